@@ -9,9 +9,14 @@ if [ ! -z ${CMAKE_CXX_COMPILER} ]; then
     COMPILER_OPTION="-DCMAKE_CXX_COMPILER=${CMAKE_CXX_COMPILER}"
 fi
 
+if [ x"${ENABLE_CXX20}" == x"yes" ]; then
+    CXX20_OPTION="-DPTPLIB_ENABLE_CXX20=ON"
+fi
+
 cmake -DCMAKE_BUILD_TYPE=${CMAKE_BUILD_TYPE} \
       -DCMAKE_CXX_FLAGS="${FLAGS}" \
       ${COMPILER_OPTION} \
+      ${CXX20_OPTION} \
       ..
 
 make -j4
@@ -33,6 +38,8 @@ make -j4
 
 ./PTP-Example
 
+./PTP-Log-Decoder example.blog
+
 #protocol example
 cd ../../protocol_example/ && rm -rf build && mkdir -p build && cd build
 
@@ -50,4 +57,50 @@ cmake \
 
 make -j4
 
-./Protocol-Example 2 10 0.1 5 
\ No newline at end of file
+./Protocol-Example 2 10 0.1 5
+
+#benchmark example
+cd ../../benchmark_example/ && rm -rf build && mkdir -p build && cd build
+cmake \
+    -DCMAKE_BUILD_TYPE=${CMAKE_BUILD_TYPE} \
+    -DCMAKE_CXX_FLAGS="${FLAGS}" \
+    ..
+
+make -j4
+
+./ThreadPool-Batch-Benchmark
+
+./SafePtr-Read-Benchmark
+
+./MultiLock-Latency-Benchmark
+
+./Log-Throughput-Benchmark
+
+./PrintBold-Throughput-Benchmark
+
+./StopWatch-Overhead-Benchmark
+
+./LemmaArena-Benchmark
+
+./StringUtils-Benchmark
+
+./NumberCodecs-Benchmark
+
+./CommandDispatch-Benchmark
+
+./PartitionTree-Benchmark
+
+./TimerWheel-Latency-Benchmark
+
+#coroutine example
+if [ x"${ENABLE_CXX20}" == x"yes" ]; then
+    cd ../../coroutine_example/ && rm -rf build && mkdir -p build && cd build
+    cmake \
+        -DCMAKE_BUILD_TYPE=${CMAKE_BUILD_TYPE} \
+        -DCMAKE_CXX_FLAGS="${FLAGS}" \
+        ..
+
+    make -j4
+
+    ./Coroutine-Example
+fi
@@ -0,0 +1,353 @@
+/*
+ * Copyright (c) 2022, Seyedmasoud Asadzadeh <seyedmasoud.asadzadeh@usi.ch>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PTPLIB_COMMON_BINARYLOG_HPP
+#define PTPLIB_COMMON_BINARYLOG_HPP
+
+#include "Printer.hpp"
+#include "PTPLib/threads/ProfiledMutex.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// PTPLIB_BLOG(log, Info, PUSH, color, "[t PUSH ] -> size: {}", n) appends a binary record to a binary_log; the format
+// and the argument types are registered once per call site and only the argument bytes are written per record.
+// Level and category filtering are the same as PTPLIB_LOG.
+#define PTPLIB_BLOG(log, level, category, color, ...)                                                                \
+    do {                                                                                                             \
+        if constexpr (PTPLib::common::log_compiled_in(PTPLib::common::log_level::level)) {                           \
+            if ((log).enabled(PTPLib::common::log_level::level, PTPLib::common::log_category::category)) {           \
+                static PTPLib::common::log_site_id ptplib_log_site;                                                  \
+                (log).write(ptplib_log_site, PTPLib::common::log_level::level,                                       \
+                            PTPLib::common::log_category::category, __FILE__, __LINE__, color, __VA_ARGS__);         \
+            }                                                                                                        \
+        }                                                                                                            \
+    } while (false)
+
+namespace PTPLib::common {
+
+    enum class log_arg_type : std::uint8_t { SIGNED, UNSIGNED, FLOAT, BOOL, CHAR, STRING };
+
+    // Filled in by the first record written through the call site; 0 means not registered yet.
+    struct log_site_id {
+        std::atomic<std::uint32_t> id = 0;
+    };
+
+    struct log_site {
+        std::uint32_t id = 0;
+        log_level level = log_level::Info;
+        log_category category = log_category::GENERAL;
+        Color::Code color = Color::FG_DEFAULT;
+        std::uint32_t line = 0;
+        std::string file;
+        std::string format;
+        std::vector<log_arg_type> types;
+    };
+
+    // Process-wide, so a site has the same id in every binary_log.
+    class log_site_registry {
+        std::mutex registry_mutex;
+        std::vector<std::unique_ptr<log_site>> sites;
+
+    public:
+        static log_site_registry & instance() {
+            static log_site_registry registry;
+            return registry;
+        }
+
+        std::uint32_t register_site(log_site_id & site_id, log_site site) {
+            const std::scoped_lock lock(registry_mutex);
+            std::uint32_t id = site_id.id.load(std::memory_order_relaxed);
+            if (id != 0)
+                return id;
+            id = static_cast<std::uint32_t>(sites.size() + 1);
+            site.id = id;
+            sites.push_back(std::make_unique<log_site>(std::move(site)));
+            site_id.id.store(id, std::memory_order_release);
+            return id;
+        }
+
+        log_site get(std::uint32_t id) {
+            const std::scoped_lock lock(registry_mutex);
+            return *sites.at(id - 1);
+        }
+    };
+
+    // File layout: the magic, then records. A site record (kind 1) precedes the first data record (kind 0) of its site:
+    //   site: kind u8, id u32, level u8, category u8, color i32, line u32, type count u16, types u8..., file, format
+    //   data: kind u8, id u32, system clock ns i64, payload size u32, payload
+    // Strings are a u32 length and the bytes; numbers are written in host byte order, so decode on the same kind of
+    // machine. Integers widen to 64 bits and floating point to double.
+    class binary_log : public log_filter {
+    public:
+        static constexpr char magic[8] = {'P', 'T', 'P', 'B', 'L', 'O', 'G', '1'};
+        enum record_kind : std::uint8_t { DATA = 0, SITE = 1 };
+
+        // Records are buffered and written out whenever buffer_bytes have accumulated, on flush() and on destruction.
+        explicit binary_log(std::ostream & _out_stream, std::size_t _buffer_bytes = 1 << 16)
+        : out_stream(_out_stream)
+        , buffer_bytes(_buffer_bytes) {
+            out_stream.write(magic, sizeof(magic));
+        }
+
+        binary_log(const binary_log &) = delete;
+
+        binary_log & operator=(const binary_log &) = delete;
+
+        ~binary_log() { flush(); }
+
+        template<typename... T>
+        void write(log_site_id & site_id, log_level level, log_category category, const char * file, int line,
+                   Color::Code colorCode, const char * format, const T & ...items) {
+            std::uint32_t id = site_id.id.load(std::memory_order_acquire);
+            if (id == 0) {
+                log_site site;
+                site.level = level;
+                site.category = category;
+                site.color = colorCode;
+                site.line = static_cast<std::uint32_t>(line);
+                site.file = file;
+                site.format = format;
+                site.types = {arg_type<T>()...};
+                id = log_site_registry::instance().register_site(site_id, std::move(site));
+            }
+            thread_local std::string payload;
+            payload.clear();
+            (encode(payload, items), ...);
+            const std::int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+
+            const std::scoped_lock lock(log_mutex);
+            if (emitted.size() <= id)
+                emitted.resize(id + 1, false);
+            if (not emitted[id]) {
+                emitted[id] = true;
+                write_site(log_site_registry::instance().get(id));
+            }
+            put<std::uint8_t>(buffer, DATA);
+            put<std::uint32_t>(buffer, id);
+            put<std::int64_t>(buffer, now);
+            put_string(buffer, payload);
+            if (buffer.size() >= buffer_bytes)
+                write_buffer();
+        }
+
+        void flush() {
+            const std::scoped_lock lock(log_mutex);
+            write_buffer();
+            out_stream.flush();
+        }
+
+    private:
+        template<typename T>
+        static constexpr log_arg_type arg_type() {
+            if constexpr (std::is_same_v<T, bool>)
+                return log_arg_type::BOOL;
+            else if constexpr (std::is_same_v<T, char> or std::is_same_v<T, signed char> or std::is_same_v<T, unsigned char>)
+                return log_arg_type::CHAR;
+            else if constexpr (std::is_enum_v<T> or (std::is_integral_v<T> and std::is_signed_v<T>))
+                return log_arg_type::SIGNED;
+            else if constexpr (std::is_integral_v<T>)
+                return log_arg_type::UNSIGNED;
+            else if constexpr (std::is_floating_point_v<T>)
+                return log_arg_type::FLOAT;
+            else {
+                static_assert(std::is_convertible_v<const T &, std::string_view>, "binary_log: unsupported argument type");
+                return log_arg_type::STRING;
+            }
+        }
+
+        template<typename T>
+        static void put(std::string & out, T value) {
+            char bytes[sizeof(T)];
+            std::memcpy(bytes, &value, sizeof(T));
+            out.append(bytes, sizeof(T));
+        }
+
+        static void put_string(std::string & out, std::string_view value) {
+            put<std::uint32_t>(out, static_cast<std::uint32_t>(value.size()));
+            out.append(value.data(), value.size());
+        }
+
+        template<typename T>
+        static void encode(std::string & out, const T & item) {
+            constexpr log_arg_type type = arg_type<T>();
+            if constexpr (type == log_arg_type::BOOL)
+                put<std::uint8_t>(out, item);
+            else if constexpr (type == log_arg_type::CHAR)
+                put<char>(out, static_cast<char>(item));
+            else if constexpr (type == log_arg_type::SIGNED)
+                put<std::int64_t>(out, static_cast<std::int64_t>(item));
+            else if constexpr (type == log_arg_type::UNSIGNED)
+                put<std::uint64_t>(out, static_cast<std::uint64_t>(item));
+            else if constexpr (type == log_arg_type::FLOAT)
+                put<double>(out, static_cast<double>(item));
+            else
+                put_string(out, std::string_view(item));
+        }
+
+        void write_site(const log_site & site) {
+            put<std::uint8_t>(buffer, SITE);
+            put<std::uint32_t>(buffer, site.id);
+            put<std::uint8_t>(buffer, static_cast<std::uint8_t>(site.level));
+            put<std::uint8_t>(buffer, static_cast<std::uint8_t>(site.category));
+            put<std::int32_t>(buffer, site.color);
+            put<std::uint32_t>(buffer, site.line);
+            put<std::uint16_t>(buffer, static_cast<std::uint16_t>(site.types.size()));
+            for (log_arg_type type : site.types)
+                put<std::uint8_t>(buffer, static_cast<std::uint8_t>(type));
+            put_string(buffer, site.file);
+            put_string(buffer, site.format);
+        }
+
+        void write_buffer() {
+            out_stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            buffer.clear();
+        }
+
+        PTPLib::threads::site_mutex<std::mutex> log_mutex = PTPLib::threads::make_site_mutex<std::mutex>("binary_log::log_mutex");
+        std::ostream & out_stream;
+        const std::size_t buffer_bytes;
+        std::string buffer;
+        std::vector<bool> emitted;
+    };
+
+    // Turns a binary_log back into the colored text synced_stream would have printed: every {} of the site's format
+    // is replaced by the next argument, arguments left over are appended.
+    class binary_log_decoder {
+        std::istream & in_stream;
+        std::unordered_map<std::uint32_t, log_site> sites;
+
+        template<typename T>
+        bool get(T & value) {
+            char bytes[sizeof(T)];
+            if (not in_stream.read(bytes, sizeof(T)))
+                return false;
+            std::memcpy(&value, bytes, sizeof(T));
+            return true;
+        }
+
+        bool get_string(std::string & value) {
+            std::uint32_t size;
+            if (not get(size))
+                return false;
+            value.resize(size);
+            return size == 0 or static_cast<bool>(in_stream.read(value.data(), size));
+        }
+
+        bool read_site() {
+            log_site site;
+            std::uint8_t level, category;
+            std::int32_t color;
+            std::uint16_t count;
+            if (not (get(site.id) and get(level) and get(category) and get(color) and get(site.line) and get(count)))
+                return false;
+            site.level = static_cast<log_level>(level);
+            site.category = static_cast<log_category>(category);
+            site.color = static_cast<Color::Code>(color);
+            for (std::uint16_t i = 0; i < count; ++i) {
+                std::uint8_t type;
+                if (not get(type))
+                    return false;
+                site.types.push_back(static_cast<log_arg_type>(type));
+            }
+            if (not (get_string(site.file) and get_string(site.format)))
+                return false;
+            sites[site.id] = std::move(site);
+            return true;
+        }
+
+        static bool format_arg(std::ostream & out, log_arg_type type, std::string_view & payload) {
+            auto take = [&payload](auto & value) {
+                if (payload.size() < sizeof(value))
+                    return false;
+                std::memcpy(&value, payload.data(), sizeof(value));
+                payload.remove_prefix(sizeof(value));
+                return true;
+            };
+            switch (type) {
+                case log_arg_type::SIGNED: { std::int64_t v; if (not take(v)) return false; out << v; return true; }
+                case log_arg_type::UNSIGNED: { std::uint64_t v; if (not take(v)) return false; out << v; return true; }
+                case log_arg_type::FLOAT: { double v; if (not take(v)) return false; out << v; return true; }
+                case log_arg_type::BOOL: { std::uint8_t v; if (not take(v)) return false; out << (v != 0); return true; }
+                case log_arg_type::CHAR: { char v; if (not take(v)) return false; out << v; return true; }
+                case log_arg_type::STRING: {
+                    std::uint32_t size;
+                    if (not take(size) or payload.size() < size)
+                        return false;
+                    out << payload.substr(0, size);
+                    payload.remove_prefix(size);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    public:
+        explicit binary_log_decoder(std::istream & _in_stream) : in_stream(_in_stream) {}
+
+        // Prints every record to out, prefixed by its local time when with_time is set. Returns false on a missing
+        // magic, a truncated record or a record of an unknown site.
+        bool decode(synced_stream & out, bool with_time = false) {
+            char header[sizeof(binary_log::magic)];
+            if (not in_stream.read(header, sizeof(header)) or std::memcmp(header, binary_log::magic, sizeof(header)) != 0)
+                return false;
+            std::string payload;
+            std::ostringstream text;
+            while (true) {
+                std::uint8_t kind;
+                if (not get(kind))
+                    return in_stream.eof();
+                if (kind == binary_log::SITE) {
+                    if (not read_site())
+                        return false;
+                    continue;
+                }
+                std::uint32_t id;
+                std::int64_t time_ns;
+                if (kind != binary_log::DATA or not (get(id) and get(time_ns) and get_string(payload)))
+                    return false;
+                auto site = sites.find(id);
+                if (site == sites.end())
+                    return false;
+                text.str(std::string());
+                if (with_time) {
+                    std::time_t seconds = static_cast<std::time_t>(time_ns / 1000000000);
+                    struct tm tm = *std::localtime(&seconds);
+                    text << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << '.' << std::setw(3) << std::setfill('0')
+                         << (time_ns / 1000000) % 1000 << std::setfill(' ') << '\t';
+                }
+                std::string_view rest = payload;
+                std::string_view format = site->second.format;
+                for (log_arg_type type : site->second.types) {
+                    const std::size_t placeholder = format.find("{}");
+                    text << format.substr(0, placeholder);
+                    format.remove_prefix(placeholder == std::string_view::npos ? format.size() : placeholder + 2);
+                    if (not format_arg(text, type, rest))
+                        return false;
+                }
+                text << format;
+                out.println(site->second.color, text.str());
+            }
+        }
+    };
+}
+
+#endif // PTPLIB_COMMON_BINARYLOG_HPP
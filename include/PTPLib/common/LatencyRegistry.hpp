@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2022, Seyedmasoud Asadzadeh <seyedmasoud.asadzadeh@usi.ch>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PTPLIB_COMMON_LATENCYREGISTRY_HPP
+#define PTPLIB_COMMON_LATENCYREGISTRY_HPP
+
+#include "Printer.hpp"
+#include "PTPLib/threads/InstanceLocal.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace PTPLib::common {
+
+    // A log-linear histogram of nanosecond values: exact below 64 ns, then 32 buckets per power of two, so a recorded
+    // value is off by at most 1/32 (about 3%). Only one thread records into it; any thread may read it.
+    class latency_histogram {
+    public:
+        static constexpr int sub_bucket_bits = 5;
+        static constexpr std::size_t linear_limit = 64;
+        static constexpr std::size_t bucket_count = linear_limit + (64 - 6) * (std::size_t(1) << sub_bucket_bits);
+
+        static std::size_t bucket_of(std::uint64_t value) {
+            if (value < linear_limit)
+                return static_cast<std::size_t>(value);
+            int exponent = 63;
+            while (not (value >> exponent))
+                --exponent;
+            const std::uint64_t sub_bucket = (value >> (exponent - sub_bucket_bits)) & ((1u << sub_bucket_bits) - 1);
+            return linear_limit + static_cast<std::size_t>(exponent - 6) * (std::size_t(1) << sub_bucket_bits)
+                   + static_cast<std::size_t>(sub_bucket);
+        }
+
+        // The largest value that falls into the bucket.
+        static std::uint64_t bucket_upper(std::size_t bucket) {
+            if (bucket < linear_limit)
+                return bucket;
+            const std::size_t exponent = (bucket - linear_limit) / (std::size_t(1) << sub_bucket_bits) + 6;
+            const std::uint64_t sub_bucket = (bucket - linear_limit) % (std::size_t(1) << sub_bucket_bits);
+            const std::uint64_t lower = (std::uint64_t(1) << exponent) + (sub_bucket << (exponent - sub_bucket_bits));
+            return lower + (std::uint64_t(1) << (exponent - sub_bucket_bits)) - 1;
+        }
+
+        // Single writer, so a relaxed load and store replace the read-modify-write.
+        void record(std::uint64_t value) {
+            auto & bucket = buckets[bucket_of(value)];
+            bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            total.store(total.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+            if (value > max.load(std::memory_order_relaxed))
+                max.store(value, std::memory_order_relaxed);
+        }
+
+        void reset() {
+            for (auto & bucket : buckets)
+                bucket.store(0, std::memory_order_relaxed);
+            total.store(0, std::memory_order_relaxed);
+            max.store(0, std::memory_order_relaxed);
+        }
+
+        std::array<std::atomic<std::uint64_t>, bucket_count> buckets{};
+        std::atomic<std::uint64_t> total = 0;
+        std::atomic<std::uint64_t> max = 0;
+    };
+
+    struct latency_summary {
+        std::string name;
+        std::uint64_t count = 0;
+        std::uint64_t mean_ns = 0;
+        std::uint64_t p50_ns = 0;
+        std::uint64_t p99_ns = 0;
+        std::uint64_t p999_ns = 0;
+        std::uint64_t max_ns = 0;
+    };
+
+    // Named latency histograms. Every recording thread gets its own histogram per name, so recording takes no lock and
+    // shares no cache line; reading merges the threads' histograms of a name. Up to max_scopes names are kept.
+    class LatencyRegistry {
+        struct thread_histograms {
+            std::unique_ptr<std::atomic<latency_histogram *>[]> histograms;
+            std::vector<std::unique_ptr<latency_histogram>> owned;
+            std::unordered_map<std::string, std::uint32_t> name_cache;
+
+            explicit thread_histograms(std::size_t max_scopes) : histograms(new std::atomic<latency_histogram *>[max_scopes]) {
+                for (std::size_t i = 0; i < max_scopes; ++i)
+                    histograms[i].store(nullptr, std::memory_order_relaxed);
+            }
+        };
+
+        const std::uint64_t registry_id;
+        const std::size_t max_scopes;
+
+        mutable std::mutex registry_mutex;
+        std::vector<std::unique_ptr<thread_histograms>> threads;
+        std::vector<std::string> names;
+        std::unordered_map<std::string, std::uint32_t> name_ids;
+
+        thread_histograms & local_histograms() {
+            thread_local PTPLib::threads::instance_local<thread_histograms> local;
+            if (thread_histograms * histograms = local.find(registry_id))
+                return *histograms;
+            const std::scoped_lock lock(registry_mutex);
+            threads.push_back(std::make_unique<thread_histograms>(max_scopes));
+            local.insert(registry_id, threads.back().get());
+            return *threads.back();
+        }
+
+        static std::uint64_t percentile(const std::vector<std::uint64_t> & merged, std::uint64_t count, double p) {
+            const auto rank = static_cast<std::uint64_t>(p * static_cast<double>(count - 1)) + 1;
+            std::uint64_t seen = 0;
+            for (std::size_t bucket = 0; bucket < merged.size(); ++bucket) {
+                seen += merged[bucket];
+                if (seen >= rank)
+                    return latency_histogram::bucket_upper(bucket);
+            }
+            return 0;
+        }
+
+    public:
+        typedef std::uint32_t scope_id;
+
+        explicit LatencyRegistry(std::size_t _max_scopes = 64)
+        : registry_id(PTPLib::threads::instance_ids::acquire())
+        , max_scopes(_max_scopes) {}
+
+        ~LatencyRegistry() { PTPLib::threads::instance_ids::release(registry_id); }
+
+        LatencyRegistry(const LatencyRegistry &) = delete;
+
+        LatencyRegistry & operator=(const LatencyRegistry &) = delete;
+
+        // Interns name; resolve it once and record through the id on hot paths.
+        scope_id scope(const std::string & name) {
+            const std::scoped_lock lock(registry_mutex);
+            auto inserted = name_ids.emplace(name, static_cast<scope_id>(names.size()));
+            if (inserted.second) {
+                if (names.size() == max_scopes) {
+                    name_ids.erase(inserted.first);
+                    throw std::length_error("LatencyRegistry: more than max_scopes names");
+                }
+                names.push_back(name);
+            }
+            return inserted.first->second;
+        }
+
+        void record(scope_id id, std::uint64_t nanoseconds) {
+            thread_histograms & local = local_histograms();
+            latency_histogram * histogram = local.histograms[id].load(std::memory_order_relaxed);
+            if (not histogram) {
+                local.owned.push_back(std::make_unique<latency_histogram>());
+                histogram = local.owned.back().get();
+                local.histograms[id].store(histogram, std::memory_order_release);
+            }
+            histogram->record(nanoseconds);
+        }
+
+        void record(const std::string & name, std::uint64_t nanoseconds) {
+            thread_histograms & local = local_histograms();
+            auto it = local.name_cache.find(name);
+            if (it == local.name_cache.end())
+                it = local.name_cache.emplace(name, scope(name)).first;
+            record(it->second, nanoseconds);
+        }
+
+        // Merges every thread's histogram of each name; values recorded meanwhile may or may not be counted.
+        std::vector<latency_summary> snapshot() const {
+            const std::scoped_lock lock(registry_mutex);
+            std::vector<latency_summary> summaries;
+            std::vector<std::uint64_t> merged(latency_histogram::bucket_count);
+            for (std::size_t id = 0; id < names.size(); ++id) {
+                std::fill(merged.begin(), merged.end(), 0);
+                latency_summary summary;
+                summary.name = names[id];
+                std::uint64_t total = 0;
+                for (auto & thread : threads) {
+                    const latency_histogram * histogram = thread->histograms[id].load(std::memory_order_acquire);
+                    if (not histogram)
+                        continue;
+                    for (std::size_t bucket = 0; bucket < merged.size(); ++bucket) {
+                        const std::uint64_t n = histogram->buckets[bucket].load(std::memory_order_relaxed);
+                        merged[bucket] += n;
+                        summary.count += n;
+                    }
+                    total += histogram->total.load(std::memory_order_relaxed);
+                    summary.max_ns = std::max(summary.max_ns, histogram->max.load(std::memory_order_relaxed));
+                }
+                if (summary.count != 0) {
+                    summary.mean_ns = total / summary.count;
+                    summary.p50_ns = std::min(percentile(merged, summary.count, 0.5), summary.max_ns);
+                    summary.p99_ns = std::min(percentile(merged, summary.count, 0.99), summary.max_ns);
+                    summary.p999_ns = std::min(percentile(merged, summary.count, 0.999), summary.max_ns);
+                }
+                summaries.push_back(std::move(summary));
+            }
+            return summaries;
+        }
+
+        // Clears the counts but keeps the names; meant for between runs, values recorded meanwhile may survive.
+        void reset() {
+            const std::scoped_lock lock(registry_mutex);
+            for (auto & thread : threads) {
+                for (std::size_t id = 0; id < names.size(); ++id) {
+                    if (latency_histogram * histogram = thread->histograms[id].load(std::memory_order_acquire))
+                        histogram->reset();
+                }
+            }
+        }
+
+        // One line per name, times in microseconds.
+        void write_report(std::ostream & stream) const {
+            stream << std::left << std::setw(32) << "scope" << std::right << std::setw(12) << "count"
+                   << std::setw(12) << "mean us" << std::setw(12) << "p50 us" << std::setw(12) << "p99 us"
+                   << std::setw(12) << "p999 us" << std::setw(12) << "max us" << '\n';
+            stream << std::fixed << std::setprecision(1);
+            for (auto & summary : snapshot()) {
+                stream << std::left << std::setw(32) << summary.name << std::right << std::setw(12) << summary.count
+                       << std::setw(12) << summary.mean_ns / 1e3 << std::setw(12) << summary.p50_ns / 1e3
+                       << std::setw(12) << summary.p99_ns / 1e3 << std::setw(12) << summary.p999_ns / 1e3
+                       << std::setw(12) << summary.max_ns / 1e3 << '\n';
+            }
+            stream << std::defaultfloat;
+        }
+
+        void print(synced_stream & ss, Color::Code colorCode = Color::FG_DEFAULT) const {
+            for (auto & summary : snapshot())
+                ss.println(colorCode, ";", summary.name, " count: ", summary.count, " p50: ", summary.p50_ns / 1000,
+                           " us p99: ", summary.p99_ns / 1000, " us p999: ", summary.p999_ns / 1000,
+                           " us max: ", summary.max_ns / 1000, " us");
+        }
+    };
+
+    // Records the lifetime of the scope into a LatencyRegistry instead of printing it like PrintStopWatch.
+    class ScopedLatencyRecorder {
+        LatencyRegistry & registry;
+        const LatencyRegistry::scope_id id;
+        const std::chrono::steady_clock::time_point start;
+
+    public:
+        ScopedLatencyRecorder(LatencyRegistry & _registry, LatencyRegistry::scope_id _id)
+        : registry(_registry)
+        , id(_id)
+        , start(std::chrono::steady_clock::now()) {}
+
+        ScopedLatencyRecorder(LatencyRegistry & _registry, const std::string & name)
+        : ScopedLatencyRecorder(_registry, _registry.scope(name)) {}
+
+        ScopedLatencyRecorder(const ScopedLatencyRecorder &) = delete;
+
+        ScopedLatencyRecorder & operator=(const ScopedLatencyRecorder &) = delete;
+
+        ~ScopedLatencyRecorder() {
+            registry.record(id, static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+        }
+    };
+}
+
+#endif // PTPLIB_COMMON_LATENCYREGISTRY_HPP
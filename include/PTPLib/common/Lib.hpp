@@ -19,28 +19,114 @@
 #include <functional>
 #include <utility>
 #include <cstdint>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <string_view>
+#include <charconv>
+#include <system_error>
+#include <type_traits>
+
+// The pieces of a string between delimiters, as views into it: nothing is copied or allocated. With a limit, the
+// last of at most limit pieces is the rest of the string. An empty string is one empty piece.
+class split_range {
+    std::string_view string;
+    std::string_view delimiter;
+    uint32_t limit;
+
+public:
+    class iterator {
+        std::string_view string;
+        std::string_view delimiter;
+        size_t next = std::string_view::npos;
+        size_t position = std::string_view::npos;
+        uint32_t left = 0;
+        std::string_view piece;
+
+        void find_piece() {
+            const size_t e = (left == 1 or delimiter.empty()) ? std::string_view::npos : string.find(delimiter, position);
+            piece = string.substr(position, e == std::string_view::npos ? e : e - position);
+            next = e == std::string_view::npos ? e : e + delimiter.size();
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string_view *;
+        using reference = const std::string_view &;
+
+        iterator() = default;
+
+        iterator(std::string_view _string, std::string_view _delimiter, uint32_t limit)
+        : string(_string)
+        , delimiter(_delimiter)
+        , position(0)
+        , left(limit) {
+            find_piece();
+        }
+
+        reference operator*() const { return piece; }
+
+        pointer operator->() const { return &piece; }
+
+        iterator & operator++() {
+            position = next;
+            if (position != std::string_view::npos) {
+                if (left > 1)
+                    --left;
+                find_piece();
+            }
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const iterator & other) const { return position == other.position; }
+
+        bool operator!=(const iterator & other) const { return position != other.position; }
+    };
+
+    split_range(std::string_view _string, std::string_view _delimiter, uint32_t _limit = 0)
+    : string(_string)
+    , delimiter(_delimiter)
+    , limit(_limit) {}
+
+    iterator begin() const { return iterator(string, delimiter, limit); }
+
+    iterator end() const { return iterator(); }
+};
+
+// The string must outlive the range.
+inline split_range split_view(std::string_view string, std::string_view delimiter, uint32_t limit = 0) {
+    return split_range(string, delimiter, limit);
+}
+
+// The non-empty runs of characters not in separators, as views into the string.
+template<typename Callback>
+inline void tokenize(std::string_view string, std::string_view separators, Callback && callback) {
+    size_t b = string.find_first_not_of(separators);
+    while (b != std::string_view::npos) {
+        const size_t e = string.find_first_of(separators, b);
+        callback(string.substr(b, e == std::string_view::npos ? e : e - b));
+        b = string.find_first_not_of(separators, e);
+    }
+}
 
 inline void split(const std::string & string, const std::string & delimiter,
                   std::function<void(const std::string &)> callback, uint32_t limit = 0) {
-    size_t b = 0;
-    size_t e;
-    while (true) {
-        if (limit != 0 && --limit == 0)
-            e = std::string::npos;
-        else
-            e = string.find(delimiter, b);
-        callback(string.substr(b, e - b));
-        if (e == std::string::npos)
-            return;
-        b = e + delimiter.size();
-    }
+    for (std::string_view piece : split_view(string, delimiter, limit))
+        callback(std::string(piece));
 }
 
 inline std::vector<std::string> split(const std::string & string, const std::string & delimiter, uint32_t limit = 0) {
     std::vector<std::string> vector;
-    split(string, delimiter, [&vector](const std::string & sub) {
-        vector.push_back(sub);
-    }, limit);
+    for (std::string_view piece : split_view(string, delimiter, limit))
+        vector.emplace_back(piece);
     return vector;
 }
 
@@ -60,19 +146,67 @@ inline std::istream & split(std::istream & stream, const char delimiter, std::ve
 }
 
 
-inline std::string & replace(std::string & string, std::string const & from, std::string const & to, size_t n = 0) {
-    if (from.empty())
-        return string;
-    size_t start_pos = 0;
-    while ((start_pos = string.find(from, start_pos)) != std::string::npos) {
-        string.replace(start_pos, from.length(), to);
-        start_pos += to.length();
-        if (n > 0) {
-            if (n == 1)
+// Replaces every pattern with its replacement in one pass over string, appending the result to out. At each position
+// the first pattern that matches wins; replaced text is not searched again, unlike chained calls of replace().
+inline void replace_all(std::string_view string, std::initializer_list<std::pair<std::string_view, std::string_view>> patterns,
+                        std::string & out) {
+    bool first_chars[256] = {};
+    for (auto & pattern : patterns) {
+        if (not pattern.first.empty())
+            first_chars[static_cast<unsigned char>(pattern.first.front())] = true;
+    }
+    out.reserve(out.size() + string.size());
+    size_t copied = 0;
+    for (size_t i = 0; i < string.size();) {
+        if (not first_chars[static_cast<unsigned char>(string[i])]) {
+            ++i;
+            continue;
+        }
+        const std::pair<std::string_view, std::string_view> * match = nullptr;
+        for (auto & pattern : patterns) {
+            if (not pattern.first.empty() and string.compare(i, pattern.first.size(), pattern.first) == 0) {
+                match = &pattern;
                 break;
-            n--;
+            }
+        }
+        if (not match) {
+            ++i;
+            continue;
         }
+        out.append(string.data() + copied, i - copied);
+        out.append(match->second);
+        i += match->first.size();
+        copied = i;
     }
+    out.append(string.data() + copied, string.size() - copied);
+}
+
+inline std::string replace_all(std::string_view string, std::initializer_list<std::pair<std::string_view, std::string_view>> patterns) {
+    std::string out;
+    replace_all(string, patterns, out);
+    return out;
+}
+
+// Replaces the first n occurrences of from, all of them if n is 0, building the result once instead of shifting the
+// tail of the string on every occurrence.
+inline std::string & replace(std::string & string, std::string const & from, std::string const & to, size_t n = 0) {
+    if (from.empty())
+        return string;
+    size_t start_pos = string.find(from);
+    if (start_pos == std::string::npos)
+        return string;
+    std::string out;
+    out.reserve(string.size());
+    size_t copied = 0;
+    do {
+        out.append(string, copied, start_pos - copied);
+        out.append(to);
+        copied = start_pos + from.length();
+        if (n > 0 and --n == 0)
+            break;
+    } while ((start_pos = string.find(from, copied)) != std::string::npos);
+    out.append(string, copied, std::string::npos);
+    string.swap(out);
     return string;
 }
 
@@ -92,30 +226,133 @@ inline std::ostream & join(std::ostream & stream, const std::string & delimiter,
 }
 
 
+// Numbers that std::to_chars and std::from_chars convert the way a stream would: integers other than bool and the
+// character types, which streams print as characters, and floating point where the library supports it.
+template<typename T>
+inline constexpr bool is_chars_convertible_v =
+        (std::is_integral_v<T> and not std::is_same_v<T, bool> and not std::is_same_v<T, char>
+         and not std::is_same_v<T, signed char> and not std::is_same_v<T, unsigned char>
+         and not std::is_same_v<T, wchar_t> and not std::is_same_v<T, char16_t> and not std::is_same_v<T, char32_t>)
+#ifdef __cpp_lib_to_chars
+        or std::is_floating_point_v<T>
+#endif
+        ;
+
+// Enough for any integer and for floating point in the general format with precision 6.
+constexpr size_t max_chars_length = 32;
+
+// Whether stream formats numbers as a fresh one does: decimal, no width, and floating point in the general format
+// with precision 6, which is what write_chars produces.
+inline bool has_default_number_format(const std::ios_base & stream) {
+    constexpr std::ios_base::fmtflags number_flags = std::ios_base::basefield | std::ios_base::floatfield | std::ios_base::showbase
+                                                     | std::ios_base::showpoint | std::ios_base::showpos | std::ios_base::uppercase;
+    return (stream.flags() & number_flags) == std::ios_base::dec and stream.precision() == 6 and stream.width() == 0;
+}
+
+// Writes value into [first, last) as operator<< would with default flags, i.e. floating point in the general
+// format with precision 6. Returns the end of the characters written, or nullptr if they do not fit.
+template<typename T, std::enable_if_t<is_chars_convertible_v<T>, int> = 0>
+inline char * write_chars(char * first, char * last, T value) {
+    std::to_chars_result result;
+    if constexpr (std::is_floating_point_v<T>)
+        result = std::to_chars(first, last, value, std::chars_format::general, 6);
+    else
+        result = std::to_chars(first, last, value);
+    return result.ec == std::errc() ? result.ptr : nullptr;
+}
+
+// Parses the number at the start of string, after leading whitespace, like operator>> into a default-constructed
+// value: characters after the number are ignored and no number gives 0. What from_chars does not take as operator>>
+// would, e.g. a value out of range, which the stream saturates, or a negative one for an unsigned type, which it
+// wraps, is handed to a stream.
+template<typename T, std::enable_if_t<is_chars_convertible_v<T>, int> = 0>
+inline T read_chars(std::string_view string) {
+    const size_t begin = string.find_first_not_of(" \t\n\r\f\v");
+    if (begin == std::string_view::npos)
+        return T();
+    const char * first = string.data() + begin;
+    const char * const last = string.data() + string.size();
+    const char * digits = first + (*first == '+' or *first == '-');
+    const bool plain = digits != last and (('0' <= *digits and *digits <= '9') or (std::is_floating_point_v<T> and *digits == '.'))
+                       and not (std::is_unsigned_v<T> and *first == '-');
+    T value = T();
+    if (plain and std::from_chars(*first == '+' ? first + 1 : first, last, value).ec == std::errc())
+        return value;
+    value = T();
+    std::istringstream(std::string(string)) >> value;
+    return value;
+}
+
+// Appends obj to out, a buffer the caller can reuse, without a stream for numbers.
+template<typename T>
+inline std::string & append_string(std::string & out, const T & obj) {
+    if constexpr (is_chars_convertible_v<T>) {
+        char buffer[max_chars_length];
+        out.append(buffer, write_chars(buffer, buffer + sizeof(buffer), obj));
+    }
+    else {
+        std::ostringstream ss;
+        ss << obj;
+        out.append(ss.str());
+    }
+    return out;
+}
+
 template<typename T>
 inline std::ostream & operator<<(std::ostream & stream, const std::vector<T> & v) {
-    for (auto & i:v) {
-        stream << i << '\0';
+    if constexpr (is_chars_convertible_v<T>) {
+        if (not has_default_number_format(stream)) {
+            for (auto & i:v)
+                stream << i << '\0';
+            return stream;
+        }
+        char buffer[max_chars_length + 1];
+        for (auto & i:v) {
+            char * end = write_chars(buffer, buffer + max_chars_length, i);
+            *end++ = '\0';
+            stream.write(buffer, end - buffer);
+        }
+    }
+    else {
+        for (auto & i:v) {
+            stream << i << '\0';
+        }
     }
     return stream;
 }
 
 template<typename T>
 inline std::istream & operator>>(std::istream & stream, std::vector<T> & v) {
-    return split(stream, '\0', [&](std::string sub) {
-        if (sub.size() == 0)
-            return;
-        T t;
-        std::istringstream(sub) >> t;
-        v.push_back(t);
-    });
+    if constexpr (is_chars_convertible_v<T>) {
+        std::string sub;
+        while (std::getline(stream, sub, '\0')) {
+            if (not sub.empty())
+                v.push_back(read_chars<T>(sub));
+        }
+        return stream;
+    }
+    else {
+        return split(stream, '\0', [&](std::string sub) {
+            if (sub.size() == 0)
+                return;
+            T t;
+            std::istringstream(sub) >> t;
+            v.push_back(t);
+        });
+    }
 }
 
 template<typename T>
 inline std::string to_string(const T & obj) {
-    std::ostringstream ss;
-    ss << obj;
-    return ss.str();
+    if constexpr (is_chars_convertible_v<T>) {
+        char buffer[max_chars_length];
+        return std::string(buffer, write_chars(buffer, buffer + sizeof(buffer), obj));
+    }
+    else {
+        std::ostringstream ss;
+        ss << obj;
+        return ss.str();
+    }
 }
 
 template<>
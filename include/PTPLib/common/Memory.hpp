@@ -11,19 +11,32 @@
 
 #include "Exception.hpp"
 
-namespace PTPLib::common {
-
-    #if defined(__unix__) || defined(__linux__) || defined(__APPLE__)
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
 
-        #define PTPLIB_MEMORY_SUPPORTED
-        #include <sys/time.h>
-        #include <sys/resource.h>
-    
-    #else
+#if defined(__unix__) || defined(__linux__) || defined(__APPLE__)
+    #define PTPLIB_MEMORY_SUPPORTED
+    #include <sys/time.h>
+    #include <sys/resource.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#else
     #warning "measuring memory is not supported for the current OS"
-    #endif
+#endif
+
+namespace PTPLib::common {
 
-    size_t current_memory() {
+    // The peak resident set size of the process in bytes; it never goes down.
+    inline size_t peak_memory() {
         #ifdef PTPLIB_MEMORY_SUPPORTED
             struct rusage usage;
             if (getrusage(RUSAGE_SELF, &usage) != 0) {
@@ -40,5 +53,144 @@ namespace PTPLib::common {
             return 0;
         #endif
     }
+
+    // The current resident set size of the process in bytes. On Linux it is one pread of /proc/self/statm through a
+    // descriptor kept open; elsewhere it falls back to the peak.
+    inline size_t current_memory() {
+        #ifdef __linux__
+            static const int statm = open("/proc/self/statm", O_RDONLY | O_CLOEXEC);
+            static const long page_size = sysconf(_SC_PAGESIZE);
+            char buffer[128];
+            const ssize_t length = statm < 0 ? -1 : pread(statm, buffer, sizeof(buffer) - 1, 0);
+            if (length <= 0)
+                return peak_memory();
+            // statm: total program size, then resident pages.
+            const char * p = buffer;
+            const char * const end = buffer + length;
+            while (p != end and *p != ' ')
+                ++p;
+            size_t resident = 0;
+            for (++p; p < end and *p >= '0' and *p <= '9'; ++p)
+                resident = resident * 10 + static_cast<size_t>(*p - '0');
+            return resident * static_cast<size_t>(page_size);
+        #else
+            return peak_memory();
+        #endif
+    }
+
+    // A byte count kept up to date by the component owning the memory, e.g. a lemma buffer, and read by a MemoryBudget.
+    class tracked_bytes {
+        std::atomic<std::size_t> bytes = 0;
+
+    public:
+        void add(std::size_t n) { bytes.fetch_add(n, std::memory_order_relaxed); }
+
+        void sub(std::size_t n) { bytes.fetch_sub(n, std::memory_order_relaxed); }
+
+        void set(std::size_t n) { bytes.store(n, std::memory_order_relaxed); }
+
+        std::size_t get() const { return bytes.load(std::memory_order_relaxed); }
+    };
+
+    // Soft and hard limits on the resident set size. check() measures it and runs the callbacks of the limit it is
+    // over, on every check until it is back under, so a callback that sheds memory keeps shedding. Components report
+    // their share through tracked_bytes counters, which show up in the report next to the process totals.
+    class MemoryBudget {
+    public:
+        enum class pressure { NORMAL, SOFT, HARD };
+
+        typedef std::function<void(pressure, std::size_t)> callback;
+
+    private:
+        std::size_t soft_limit;
+        std::size_t hard_limit;
+
+        mutable std::mutex budget_mutex;
+        std::map<std::string, const tracked_bytes *> counters;
+        std::vector<callback> soft_callbacks;
+        std::vector<callback> hard_callbacks;
+
+    public:
+        // A limit of 0 is never reached.
+        MemoryBudget(std::size_t _soft_limit, std::size_t _hard_limit)
+        : soft_limit(_soft_limit)
+        , hard_limit(_hard_limit) {}
+
+        void set_limits(std::size_t soft, std::size_t hard) {
+            const std::scoped_lock lock(budget_mutex);
+            soft_limit = soft;
+            hard_limit = hard;
+        }
+
+        std::size_t get_soft_limit() const {
+            const std::scoped_lock lock(budget_mutex);
+            return soft_limit;
+        }
+
+        std::size_t get_hard_limit() const {
+            const std::scoped_lock lock(budget_mutex);
+            return hard_limit;
+        }
+
+        // The counter must outlive the budget or be untracked first.
+        void track(const std::string & name, const tracked_bytes & counter) {
+            const std::scoped_lock lock(budget_mutex);
+            counters[name] = &counter;
+        }
+
+        void untrack(const std::string & name) {
+            const std::scoped_lock lock(budget_mutex);
+            counters.erase(name);
+        }
+
+        // Called with the pressure and the resident set size in bytes, on the thread calling check().
+        void on_soft_limit(callback cb) {
+            const std::scoped_lock lock(budget_mutex);
+            soft_callbacks.push_back(std::move(cb));
+        }
+
+        void on_hard_limit(callback cb) {
+            const std::scoped_lock lock(budget_mutex);
+            hard_callbacks.push_back(std::move(cb));
+        }
+
+        // The callbacks run without the budget's lock held.
+        pressure check() {
+            const std::size_t rss = current_memory();
+            std::vector<callback> to_run;
+            pressure level = pressure::NORMAL;
+            {
+                const std::scoped_lock lock(budget_mutex);
+                if (hard_limit != 0 and rss >= hard_limit) {
+                    level = pressure::HARD;
+                    to_run = hard_callbacks;
+                }
+                else if (soft_limit != 0 and rss >= soft_limit) {
+                    level = pressure::SOFT;
+                    to_run = soft_callbacks;
+                }
+            }
+            for (auto & cb : to_run)
+                cb(level, rss);
+            return level;
+        }
+
+        std::size_t tracked_total() const {
+            const std::scoped_lock lock(budget_mutex);
+            std::size_t total = 0;
+            for (auto & counter : counters)
+                total += counter.second->get();
+            return total;
+        }
+
+        void write_report(std::ostream & stream) const {
+            const std::scoped_lock lock(budget_mutex);
+            stream << std::left << std::setw(32) << "current rss" << std::right << std::setw(16) << current_memory() << '\n'
+                   << std::left << std::setw(32) << "peak rss" << std::right << std::setw(16) << peak_memory() << '\n';
+            for (auto & counter : counters)
+                stream << std::left << std::setw(32) << counter.first << std::right << std::setw(16)
+                       << counter.second->get() << '\n';
+        }
+    };
 }
-#endif // PTPLIB_COMMON_MEMORY_HPP
\ No newline at end of file
+#endif // PTPLIB_COMMON_MEMORY_HPP
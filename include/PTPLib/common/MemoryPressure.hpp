@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2022, Seyedmasoud Asadzadeh <seyedmasoud.asadzadeh@usi.ch>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PTPLIB_COMMON_MEMORYPRESSURE_HPP
+#define PTPLIB_COMMON_MEMORYPRESSURE_HPP
+
+#include "Memory.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <unistd.h>
+#endif
+
+namespace PTPLib::common {
+
+    // Checks a MemoryBudget on its own thread as soon as the kernel reports memory pressure, instead of at a fixed
+    // period. On Linux it waits in poll() on a PSI trigger (the cgroup's memory.pressure, else /proc/pressure/memory)
+    // and on the cgroup v2 memory.events file, which changes when memory.high or memory.max is hit. Those report pressure
+    // on the machine or the cgroup; for the budget's own limits it also polls, at an interval that shrinks as the
+    // resident set size approaches the soft limit or grows fast, and is max_interval without a soft limit.
+    class MemoryPressureWatcher {
+    public:
+        enum class source { PSI, CGROUP_EVENTS, POLL };
+
+        struct options {
+            // PSI trigger: notify when tasks stall on memory for psi_stall within any psi_window. Unprivileged
+            // processes need a window that is a multiple of 2 s.
+            std::chrono::microseconds psi_stall = std::chrono::milliseconds(150);
+            std::chrono::microseconds psi_window = std::chrono::seconds(2);
+            std::chrono::milliseconds min_interval = std::chrono::milliseconds(10);
+            std::chrono::milliseconds max_interval = std::chrono::seconds(10);
+            // Lower the budget's soft and hard limits to the cgroup's memory.high and memory.max.
+            bool adopt_cgroup_limits = true;
+        };
+
+        // Called on the watcher thread after a kernel notification, with the budget's pressure after its check.
+        typedef std::function<void(source, MemoryBudget::pressure)> callback;
+
+    private:
+        MemoryBudget & budget;
+        const options opts;
+
+        std::mutex watcher_mutex;
+        std::condition_variable stop_cv;
+        bool stopping = false;
+        std::vector<callback> callbacks;
+
+        std::string cgroup_dir;
+        std::size_t cgroup_high = 0;
+        std::size_t cgroup_max = 0;
+        std::atomic<bool> psi_active = false;
+        std::atomic<bool> events_active = false;
+
+#ifdef __linux__
+        int stop_pipe[2] = {-1, -1};
+        int psi_fd = -1;
+        int events_fd = -1;
+        std::string events_snapshot;
+#endif
+
+        std::thread watcher;
+
+        // A byte limit file of cgroup v2; "max" and unreadable files mean no limit.
+        static std::size_t read_limit(const std::string & path) {
+            std::ifstream in(path);
+            std::string value;
+            if (not (in >> value) or value == "max")
+                return 0;
+            return static_cast<std::size_t>(std::stoull(value));
+        }
+
+        // The cgroup v2 directory of the process: the mount point of cgroup2 joined with the "0::" line of
+        // /proc/self/cgroup.
+        static std::string find_cgroup_dir() {
+            std::ifstream cgroups("/proc/self/cgroup");
+            std::string line, path;
+            while (std::getline(cgroups, line)) {
+                if (line.rfind("0::", 0) == 0)
+                    path = line.substr(3);
+            }
+            if (path.empty())
+                return std::string();
+            std::ifstream mounts("/proc/self/mountinfo");
+            while (std::getline(mounts, line)) {
+                const std::size_t separator = line.find(" - ");
+                if (separator == std::string::npos or line.compare(separator + 3, 8, "cgroup2 ") != 0)
+                    continue;
+                std::istringstream fields(line);
+                std::string id, parent, device, root, mount_point;
+                fields >> id >> parent >> device >> root >> mount_point;
+                return path == "/" ? mount_point : mount_point + path;
+            }
+            return std::string();
+        }
+
+        static std::size_t min_limit(std::size_t a, std::size_t b) {
+            return a == 0 ? b : (b == 0 ? a : std::min(a, b));
+        }
+
+        std::chrono::milliseconds next_interval(std::size_t rss, std::size_t last_rss) const {
+            const std::size_t soft = budget.get_soft_limit();
+            if (soft == 0)
+                return opts.max_interval;
+            if (rss >= soft or rss > last_rss + soft / 64)
+                return opts.min_interval;
+            const double headroom = static_cast<double>(soft - rss) / static_cast<double>(soft);
+            const auto range = opts.max_interval - opts.min_interval;
+            return opts.min_interval + std::chrono::milliseconds(static_cast<long long>(range.count() * headroom * headroom));
+        }
+
+        void notify(source from, MemoryBudget::pressure level) {
+            std::vector<callback> to_run;
+            {
+                const std::scoped_lock lock(watcher_mutex);
+                to_run = callbacks;
+            }
+            for (auto & cb : to_run)
+                cb(from, level);
+        }
+
+#ifdef __linux__
+        void open_sources() {
+            if (pipe2(stop_pipe, O_CLOEXEC) != 0)
+                stop_pipe[0] = stop_pipe[1] = -1;
+            const std::string trigger = "some " + std::to_string(opts.psi_stall.count()) + " "
+                                        + std::to_string(opts.psi_window.count());
+            for (const std::string & path : {cgroup_dir.empty() ? std::string() : cgroup_dir + "/memory.pressure",
+                                             std::string("/proc/pressure/memory")}) {
+                if (path.empty())
+                    continue;
+                psi_fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+                if (psi_fd >= 0 and write(psi_fd, trigger.c_str(), trigger.size() + 1) > 0)
+                    break;
+                if (psi_fd >= 0)
+                    close(psi_fd);
+                psi_fd = -1;
+            }
+            if (not cgroup_dir.empty()) {
+                events_fd = open((cgroup_dir + "/memory.events").c_str(), O_RDONLY | O_CLOEXEC);
+                if (events_fd >= 0)
+                    events_snapshot = read_events();
+            }
+            psi_active = psi_fd >= 0;
+            events_active = events_fd >= 0;
+        }
+
+        void close_sources() {
+            for (int fd : {psi_fd, events_fd, stop_pipe[0], stop_pipe[1]}) {
+                if (fd >= 0)
+                    close(fd);
+            }
+        }
+
+        // Reading memory.events also re-arms its poll notification.
+        std::string read_events() const {
+            char buffer[512];
+            const ssize_t length = pread(events_fd, buffer, sizeof(buffer), 0);
+            return length > 0 ? std::string(buffer, static_cast<std::size_t>(length)) : std::string();
+        }
+
+        void run() {
+            std::size_t last_rss = current_memory();
+            std::chrono::milliseconds interval = next_interval(last_rss, last_rss);
+            while (true) {
+                pollfd fds[3] = {{stop_pipe[0], POLLIN, 0}, {psi_fd, POLLPRI, 0}, {events_fd, POLLPRI, 0}};
+                const int ready = poll(fds, 3, static_cast<int>(interval.count()));
+                if (ready < 0 and errno == EINTR)
+                    continue;
+                if (fds[0].revents != 0 or stop_requested())
+                    return;
+                source from = source::POLL;
+                if (fds[1].revents & POLLERR) {
+                    close(psi_fd);
+                    psi_fd = -1;
+                    psi_active = false;
+                }
+                else if (fds[1].revents & POLLPRI)
+                    from = source::PSI;
+                if (fds[2].revents & (POLLPRI | POLLERR)) {
+                    std::string events = read_events();
+                    if (events != events_snapshot) {
+                        events_snapshot = std::move(events);
+                        from = source::CGROUP_EVENTS;
+                    }
+                }
+                const MemoryBudget::pressure level = budget.check();
+                if (from != source::POLL)
+                    notify(from, level);
+                const std::size_t rss = current_memory();
+                interval = next_interval(rss, last_rss);
+                last_rss = rss;
+            }
+        }
+#else
+        void open_sources() {}
+
+        void close_sources() {}
+
+        void run() {
+            std::size_t last_rss = current_memory();
+            std::chrono::milliseconds interval = next_interval(last_rss, last_rss);
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(watcher_mutex);
+                    if (stop_cv.wait_for(lock, interval, [this] { return stopping; }))
+                        return;
+                }
+                budget.check();
+                const std::size_t rss = current_memory();
+                interval = next_interval(rss, last_rss);
+                last_rss = rss;
+            }
+        }
+#endif
+
+        bool stop_requested() {
+            const std::scoped_lock lock(watcher_mutex);
+            return stopping;
+        }
+
+    public:
+        explicit MemoryPressureWatcher(MemoryBudget & _budget) : MemoryPressureWatcher(_budget, options()) {}
+
+        MemoryPressureWatcher(MemoryBudget & _budget, options _opts)
+        : budget(_budget)
+        , opts(_opts) {
+#ifdef __linux__
+            cgroup_dir = find_cgroup_dir();
+            if (not cgroup_dir.empty()) {
+                cgroup_high = read_limit(cgroup_dir + "/memory.high");
+                cgroup_max = read_limit(cgroup_dir + "/memory.max");
+            }
+#endif
+            if (opts.adopt_cgroup_limits and (cgroup_high != 0 or cgroup_max != 0))
+                budget.set_limits(min_limit(budget.get_soft_limit(), cgroup_high),
+                                  min_limit(budget.get_hard_limit(), cgroup_max));
+            open_sources();
+            watcher = std::thread(&MemoryPressureWatcher::run, this);
+        }
+
+        MemoryPressureWatcher(const MemoryPressureWatcher &) = delete;
+
+        MemoryPressureWatcher & operator=(const MemoryPressureWatcher &) = delete;
+
+        ~MemoryPressureWatcher() {
+            {
+                const std::scoped_lock lock(watcher_mutex);
+                stopping = true;
+            }
+            stop_cv.notify_all();
+#ifdef __linux__
+            if (stop_pipe[1] >= 0 and write(stop_pipe[1], "", 1) < 0) {}
+#endif
+            watcher.join();
+            close_sources();
+        }
+
+        void on_pressure(callback cb) {
+            const std::scoped_lock lock(watcher_mutex);
+            callbacks.push_back(std::move(cb));
+        }
+
+        // Whether the kernel notifies the watcher, or it polls.
+        bool uses_psi() const { return psi_active; }
+
+        bool uses_cgroup_events() const { return events_active; }
+
+        // The cgroup's memory.high and memory.max in bytes, 0 when unlimited or unknown.
+        std::size_t get_cgroup_high() const { return cgroup_high; }
+
+        std::size_t get_cgroup_max() const { return cgroup_max; }
+    };
+}
+
+#endif // PTPLIB_COMMON_MEMORYPRESSURE_HPP
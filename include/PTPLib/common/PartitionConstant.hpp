@@ -8,54 +8,163 @@
 #ifndef PTPLIB_COMMON_PARTITIONCONSTANT_HPP
 #define PTPLIB_COMMON_PARTITIONCONSTANT_HPP
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <string>
+#include <string_view>
 
 namespace PTPLib::common
 {
     typedef const std::string CONST_STRING;
     typedef const std::size_t CONST_SIZE;
 
+    // A collision-free hash from a fixed set of names to their index, built at compile time: the seed of an FNV-1a
+    // hash is searched until every name has a slot of its own in a table of at least twice as many slots. A lookup is
+    // one hash and one comparison; names outside the set give the id N.
+    template<typename ID, std::size_t N>
+    class perfect_hash {
+        static constexpr std::size_t slot_bits() {
+            std::size_t bits = 1;
+            while ((std::size_t(1) << bits) < 2 * N)
+                ++bits;
+            return bits;
+        }
+
+        static constexpr std::size_t slot_count = std::size_t(1) << slot_bits();
+
+        std::array<std::string_view, N> names;
+        std::array<std::uint8_t, slot_count> slots;
+        std::uint32_t seed;
+
+        static constexpr std::uint32_t hash(std::string_view name, std::uint32_t seed) {
+            std::uint32_t h = 2166136261u ^ seed;
+            for (char c : name) {
+                h ^= static_cast<unsigned char>(c);
+                h *= 16777619u;
+            }
+            return h;
+        }
+
+        constexpr std::size_t slot(std::string_view name) const {
+            return static_cast<std::uint32_t>(hash(name, seed) * 0x9E3779B1u) >> (32 - slot_bits());
+        }
+
+    public:
+        static_assert(N < 255, "perfect_hash keeps ids in a byte");
+
+        constexpr explicit perfect_hash(const std::array<std::string_view, N> & _names)
+        : names(_names)
+        , slots()
+        , seed(0) {
+            for (bool collision = true; collision; ++seed) {
+                for (std::size_t i = 0; i < slot_count; ++i)
+                    slots[i] = static_cast<std::uint8_t>(N);
+                collision = false;
+                for (std::size_t i = 0; i < N and not collision; ++i) {
+                    const std::size_t s = slot(names[i]);
+                    collision = slots[s] != N;
+                    slots[s] = static_cast<std::uint8_t>(i);
+                }
+                if (not collision)
+                    return;
+            }
+        }
+
+        constexpr ID find(std::string_view name) const {
+            const std::size_t i = slots[slot(name)];
+            return i != N and names[i] == name ? static_cast<ID>(i) : static_cast<ID>(N);
+        }
+    };
+
+    // The commands and parameters of the protocol as ids, for switching on them; the strings below are what goes over
+    // the wire. UNKNOWN stands for any other string.
+    enum class CommandId : std::uint8_t
+    {
+        PARTITION, STOP, CLAUSEINJECTION, INCREMENTAL, CNFCLAUSES, CNFLEARNTS, SOLVE, LEMMAS, TERMINATE, RESUME, UNKNOWN
+    };
+
+    inline constexpr std::array<std::string_view, static_cast<std::size_t>(CommandId::UNKNOWN)> COMMAND_NAMES = {
+        "partition", "stop", "inject", "incremental", "cnf-clauses", "cnf-learnts", "solve", "lemmas", "terminate",
+        "resume"
+    };
+
+    enum class ParamId : std::uint8_t
+    {
+        NODE, NODE_, COMMAND, QUERY, NAME, SEED, SPLIT_TYPE, SPLIT_PREFERENCE, PARTITIONS, OPENSMT2, SPACER, SALLY,
+        SOLVER, REPORT, MAX_MEMORY, SCATTER_SPLIT, SEARCH_COUNTER, STATUS_INFO, LEMMA_AMOUNT, LOG_MODE, L_PUSH_MIN,
+        L_PUSH_Max, L_PULL_MIN, L_PULL_MAX, UNKNOWN
+    };
+
+    inline constexpr std::array<std::string_view, static_cast<std::size_t>(ParamId::UNKNOWN)> PARAM_NAMES = {
+        "node", "node_", "command", "query", "name", "seed", "split-type", "split-preference", "partitions", "OpenSMT2",
+        "Spacer", "SALLY", "solver", "report", "max_memory", "scatter-split", "search_counter", "status_info",
+        "lemma_amount", "enableLog", "lemma_push_min", "lemma_push_max", "lemma_pull_min", "lemma_pull_max"
+    };
+
+    inline constexpr perfect_hash<CommandId, COMMAND_NAMES.size()> COMMAND_HASH(COMMAND_NAMES);
+
+    inline constexpr perfect_hash<ParamId, PARAM_NAMES.size()> PARAM_HASH(PARAM_NAMES);
+
+    constexpr CommandId command_id(std::string_view name) { return COMMAND_HASH.find(name); }
+
+    constexpr ParamId param_id(std::string_view name) { return PARAM_HASH.find(name); }
+
+    constexpr std::string_view command_name(CommandId id) {
+        return id == CommandId::UNKNOWN ? std::string_view() : COMMAND_NAMES[static_cast<std::size_t>(id)];
+    }
+
+    constexpr std::string_view param_name(ParamId id) {
+        return id == ParamId::UNKNOWN ? std::string_view() : PARAM_NAMES[static_cast<std::size_t>(id)];
+    }
+
+    static_assert(command_id("inject") == CommandId::CLAUSEINJECTION and command_id("resume") == CommandId::RESUME
+                  and command_id("injects") == CommandId::UNKNOWN and command_id("") == CommandId::UNKNOWN);
+    static_assert(param_id("node_") == ParamId::NODE_ and param_id("lemma_pull_max") == ParamId::L_PULL_MAX
+                  and param_id("Node") == ParamId::UNKNOWN);
+
+    // The names as strings, taken from the tables above so the two cannot disagree.
     static struct
     {
-        CONST_STRING PARTITION = "partition";
-        CONST_STRING STOP = "stop";
-        CONST_STRING CLAUSEINJECTION = "inject";
-        CONST_STRING INCREMENTAL = "incremental";
-        CONST_STRING CNFCLAUSES = "cnf-clauses";
-        CONST_STRING CNFLEARNTS = "cnf-learnts";
-        CONST_STRING SOLVE = "solve";
-        CONST_STRING LEMMAS = "lemmas";
-        CONST_STRING TERMINATE = "terminate";
-        CONST_STRING RESUME = "resume";
+        CONST_STRING PARTITION{command_name(CommandId::PARTITION)};
+        CONST_STRING STOP{command_name(CommandId::STOP)};
+        CONST_STRING CLAUSEINJECTION{command_name(CommandId::CLAUSEINJECTION)};
+        CONST_STRING INCREMENTAL{command_name(CommandId::INCREMENTAL)};
+        CONST_STRING CNFCLAUSES{command_name(CommandId::CNFCLAUSES)};
+        CONST_STRING CNFLEARNTS{command_name(CommandId::CNFLEARNTS)};
+        CONST_STRING SOLVE{command_name(CommandId::SOLVE)};
+        CONST_STRING LEMMAS{command_name(CommandId::LEMMAS)};
+        CONST_STRING TERMINATE{command_name(CommandId::TERMINATE)};
+        CONST_STRING RESUME{command_name(CommandId::RESUME)};
     } Command;
 
     static struct
     {
-        CONST_STRING NODE = "node";
-        CONST_STRING NODE_ = "node_";
-        CONST_STRING COMMAND = "command";
-        CONST_STRING QUERY = "query";
-        CONST_STRING NAME = "name";
-        CONST_STRING SEED = "seed";
-        CONST_STRING SPLIT_TYPE = "split-type";
-        CONST_STRING SPLIT_PREFERENCE = "split-preference";
-        CONST_STRING PARTITIONS = "partitions";
-        CONST_STRING OPENSMT2 = "OpenSMT2";
-        CONST_STRING SPACER = "Spacer";
-        CONST_STRING SALLY = "SALLY";
-        CONST_STRING SOLVER = "solver";
-        CONST_STRING REPORT = "report";
-        CONST_STRING MAX_MEMORY = "max_memory";
-        CONST_STRING SCATTER_SPLIT = "scatter-split";
-        CONST_STRING SEARCH_COUNTER = "search_counter";
-        CONST_STRING STATUS_INFO = "status_info";
-        CONST_STRING LEMMA_AMOUNT = "lemma_amount";
-        CONST_STRING LOG_MODE = "enableLog";
-        CONST_STRING L_PUSH_MIN = "lemma_push_min";
-        CONST_STRING L_PUSH_Max = "lemma_push_max";
-        CONST_STRING L_PULL_MIN = "lemma_pull_min";
-        CONST_STRING L_PULL_MAX= "lemma_pull_max";
-
+        CONST_STRING NODE{param_name(ParamId::NODE)};
+        CONST_STRING NODE_{param_name(ParamId::NODE_)};
+        CONST_STRING COMMAND{param_name(ParamId::COMMAND)};
+        CONST_STRING QUERY{param_name(ParamId::QUERY)};
+        CONST_STRING NAME{param_name(ParamId::NAME)};
+        CONST_STRING SEED{param_name(ParamId::SEED)};
+        CONST_STRING SPLIT_TYPE{param_name(ParamId::SPLIT_TYPE)};
+        CONST_STRING SPLIT_PREFERENCE{param_name(ParamId::SPLIT_PREFERENCE)};
+        CONST_STRING PARTITIONS{param_name(ParamId::PARTITIONS)};
+        CONST_STRING OPENSMT2{param_name(ParamId::OPENSMT2)};
+        CONST_STRING SPACER{param_name(ParamId::SPACER)};
+        CONST_STRING SALLY{param_name(ParamId::SALLY)};
+        CONST_STRING SOLVER{param_name(ParamId::SOLVER)};
+        CONST_STRING REPORT{param_name(ParamId::REPORT)};
+        CONST_STRING MAX_MEMORY{param_name(ParamId::MAX_MEMORY)};
+        CONST_STRING SCATTER_SPLIT{param_name(ParamId::SCATTER_SPLIT)};
+        CONST_STRING SEARCH_COUNTER{param_name(ParamId::SEARCH_COUNTER)};
+        CONST_STRING STATUS_INFO{param_name(ParamId::STATUS_INFO)};
+        CONST_STRING LEMMA_AMOUNT{param_name(ParamId::LEMMA_AMOUNT)};
+        CONST_STRING LOG_MODE{param_name(ParamId::LOG_MODE)};
+        CONST_STRING L_PUSH_MIN{param_name(ParamId::L_PUSH_MIN)};
+        CONST_STRING L_PUSH_Max{param_name(ParamId::L_PUSH_Max)};
+        CONST_STRING L_PULL_MIN{param_name(ParamId::L_PULL_MIN)};
+        CONST_STRING L_PULL_MAX{param_name(ParamId::L_PULL_MAX)};
     } Param;
 
     static struct {
@@ -9,13 +9,55 @@
 #define PTPLIB_COMMON_PRINTER_HPP
 
 #include "Timer.hpp"
+#include "Memory.hpp"
+#include "PTPLib/threads/ProfiledMutex.hpp"
+#include "PTPLib/threads/RingBuffer.hpp"
 
 #include <mutex>
 #include <cstring>
 #include <iomanip>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <charconv>
+#include <condition_variable>
+#include <ctime>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Calls below this level (see PTPLib::common::log_level) are compiled out of PTPLIB_LOG, arguments included.
+#ifndef PTPLIB_LOG_MIN_LEVEL
+#define PTPLIB_LOG_MIN_LEVEL 0
+#endif
+
+// PTPLIB_LOG(stream, Info, PUSH, color, items...) prints like stream.println(color, items...) if Info is at least
+// PTPLIB_LOG_MIN_LEVEL and the stream's runtime filter lets Info messages of category PUSH through; otherwise the
+// items are not evaluated at all.
+#define PTPLIB_LOG(stream, level, category, ...)                                                                     \
+    do {                                                                                                             \
+        if constexpr (PTPLib::common::log_compiled_in(PTPLib::common::log_level::level)) {                           \
+            if ((stream).enabled(PTPLib::common::log_level::level, PTPLib::common::log_category::category))          \
+                (stream).println(__VA_ARGS__);                                                                       \
+        }                                                                                                            \
+    } while (false)
 
 namespace PTPLib::common {
 
+    // Not in capitals: the level is pasted into log_level::level, and DEBUG or ERROR are often macros.
+    enum class log_level : std::uint8_t { Trace, Debug, Info, Warn, Error, Off };
+
+    // Through a variable, so a minimum of 0 does not make the comparison trip -Wtype-limits.
+    constexpr int log_min_level = PTPLIB_LOG_MIN_LEVEL;
+
+    constexpr bool log_compiled_in(log_level level) { return static_cast<int>(level) >= log_min_level; }
+
+    enum class log_category : std::uint8_t {
+        GENERAL, LISTENER, COMMUNICATOR, SEARCH, PUSH, PULL, CLAUSE_LEARN, MEMORY, THREAD_POOL, COUNT
+    };
+
     struct Color
     {
         enum Code {
@@ -55,18 +97,103 @@ namespace PTPLib::common {
         };
     };
 
-    class synced_stream {
+    // How print_bold stamps its lines: local wall-clock time to the second or to the millisecond, or seconds on the
+    // monotonic clock since the process printed its first monotonic stamp.
+    enum class timestamp_mode : std::uint8_t { seconds, milliseconds, monotonic };
+
+    // Formats print_bold's timestamp prefix. The calendar part is reformatted with localtime_r at most once per second
+    // and thread; within the second only the milliseconds are rewritten.
+    class timestamp_cache {
+        std::time_t cached_second = -1;
+        std::size_t date_length = 0;
+        char text[48];
+
+        static std::chrono::steady_clock::time_point first_stamp() {
+            static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            return start;
+        }
+
+        static char * put_padded(char * out, std::uint64_t value, int width) {
+            for (int i = width - 1; i >= 0; --i, value /= 10)
+                out[i] = static_cast<char>('0' + value % 10);
+            return out + width;
+        }
+
+    public:
+        static timestamp_cache & local() {
+            thread_local timestamp_cache cache;
+            return cache;
+        }
+
+        std::string_view prefix(timestamp_mode mode) {
+            if (mode == timestamp_mode::monotonic) {
+                const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - first_stamp()).count();
+                char * end = std::to_chars(text, text + 24, elapsed / 1000000).ptr;
+                *end++ = '.';
+                end = put_padded(end, static_cast<std::uint64_t>(elapsed % 1000000), 6);
+                *end++ = '\t';
+                cached_second = -1;
+                return std::string_view(text, static_cast<std::size_t>(end - text));
+            }
+            const auto now = std::chrono::system_clock::now();
+            const std::time_t second = std::chrono::system_clock::to_time_t(now);
+            if (second != cached_second) {
+                struct tm tm;
+                localtime_r(&second, &tm);
+                date_length = std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &tm);
+                cached_second = second;
+            }
+            char * end = text + date_length;
+            if (mode == timestamp_mode::milliseconds) {
+                const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+                *end++ = '.';
+                end = put_padded(end, static_cast<std::uint64_t>(ms), 3);
+            }
+            *end++ = '\t';
+            return std::string_view(text, static_cast<std::size_t>(end - text));
+        }
+    };
+
+    // The runtime filter of PTPLIB_LOG: a minimum level per category, checked with one relaxed load per call.
+    class log_filter {
+        std::array<std::atomic<log_level>, static_cast<std::size_t>(log_category::COUNT)> min_levels;
+
     public:
+        log_filter() { set_log_level(log_level::Trace); }
+
+        bool enabled(log_level level, log_category category) const {
+            return level >= min_levels[static_cast<std::size_t>(category)].load(std::memory_order_relaxed);
+        }
+
+        void set_log_level(log_level level) {
+            for (auto & min_level : min_levels)
+                min_level.store(level, std::memory_order_relaxed);
+        }
+
+        void set_log_level(log_category category, log_level level) {
+            min_levels[static_cast<std::size_t>(category)].store(level, std::memory_order_relaxed);
+        }
+    };
+
+    class synced_stream : public log_filter {
+    public:
+        // What an async print does when the ring of pending messages is full.
+        enum class overflow_policy { block, drop };
+
         synced_stream(std::ostream & _out_stream = std::cout)
                 : out_stream(_out_stream) {};
 
+        ~synced_stream() { clear_async(); }
+
         template<typename... T>
         void print(Color::Code colorCode, const T & ...items) {
+            if (async_sink * sink = async.load(std::memory_order_acquire)) {
+                enqueue(*sink, format([&](std::ostream & out) { write(out, colorCode, items...); }));
+                return;
+            }
             const std::scoped_lock lock(stream_mutex);
-            if (colorCode != Color::FG_DEFAULT )
-                out_stream << "\033[" << colorCode << "m";
-            (out_stream << ... << items);
-            out_stream << "\033[0m";
+            write(out_stream, colorCode, items...);
         }
 
         template<typename... T>
@@ -79,21 +206,166 @@ namespace PTPLib::common {
             print_bold(colorCode, items..., '\n');
         }
 
+        // Prefixed by a timestamp, formatted before the stream lock is taken.
         template<typename... T>
         void print_bold(Color::Code colorCode, const T & ...items) {
+            const std::string_view stamp = timestamp_cache::local().prefix(stamp_mode.load(std::memory_order_relaxed));
+            if (async_sink * sink = async.load(std::memory_order_acquire)) {
+                enqueue(*sink, format([&](std::ostream & out) { write_bold(out, colorCode, stamp, items...); }));
+                return;
+            }
             const std::scoped_lock lock(stream_mutex);
-            std::time_t time = std::time(nullptr);
-            struct tm tm = *std::localtime(&time);
-            if (colorCode != Color::FG_DEFAULT)
-                out_stream << "\e[1m" <<"\033[" << colorCode << "m";
-            (out_stream << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << "\t");
-            (out_stream << ... << items);
-            out_stream << "\033[0m";
+            write_bold(out_stream, colorCode, stamp, items...);
+        }
+
+        void set_timestamp_mode(timestamp_mode mode) { stamp_mode.store(mode, std::memory_order_relaxed); }
+
+        // Switches to async mode: callers format into a thread-local buffer and enqueue the message into a bounded
+        // ring of capacity messages; a flusher thread writes whatever is pending with a single write per batch.
+        // Switch modes only while no other thread prints.
+        void set_async(std::size_t capacity = 4096, overflow_policy policy = overflow_policy::block) {
+            clear_async();
+            sink_owner = std::make_unique<async_sink>(capacity, policy);
+            sink_owner->flusher = std::thread(&synced_stream::run_flusher, this, sink_owner.get());
+            async.store(sink_owner.get(), std::memory_order_release);
+        }
+
+        // Writes every pending message, stops the flusher and returns to synchronous printing.
+        void clear_async() {
+            if (not sink_owner)
+                return;
+            flush();
+            async.store(nullptr, std::memory_order_release);
+            {
+                const std::scoped_lock lock(sink_owner->mutex);
+                sink_owner->stopping = true;
+            }
+            sink_owner->wake_cv.notify_one();
+            sink_owner->flusher.join();
+            sink_owner.reset();
+        }
+
+        // Blocks until every message enqueued before the call has been written out.
+        void flush() {
+            async_sink * sink = async.load(std::memory_order_acquire);
+            if (not sink) {
+                const std::scoped_lock lock(stream_mutex);
+                out_stream.flush();
+                return;
+            }
+            // The flusher pops in slot order, so the messages in the slots claimed so far are written once that many are.
+            const std::uint64_t target = sink->ring.claimed();
+            std::unique_lock<std::mutex> lock(sink->mutex);
+            sink->wake_cv.notify_one();
+            sink->flushed_cv.wait(lock, [&] { return sink->written.load(std::memory_order_acquire) >= target; });
+        }
+
+        // Bytes of async messages enqueued but not yet written.
+        const tracked_bytes & pending_memory() const { return pending_bytes; }
+
+        // Messages discarded by the drop policy since async mode was set.
+        std::uint64_t get_dropped() const {
+            async_sink * sink = async.load(std::memory_order_acquire);
+            return sink ? sink->dropped.load(std::memory_order_relaxed) : 0;
         }
 
     private:
-        mutable std::mutex stream_mutex = {};
+        struct async_sink {
+            PTPLib::threads::mpsc_ring_buffer<std::string> ring;
+            const overflow_policy policy;
+            std::atomic<std::uint64_t> written = 0;
+            std::atomic<std::uint64_t> dropped = 0;
+            std::atomic<bool> sleeping = false;
+            bool stopping = false;
+            std::mutex mutex;
+            std::condition_variable wake_cv;
+            std::condition_variable flushed_cv;
+            std::thread flusher;
+
+            async_sink(std::size_t capacity, overflow_policy _policy) : ring(capacity), policy(_policy) {}
+        };
+
+        template<typename... T>
+        static void write(std::ostream & out, Color::Code colorCode, const T & ...items) {
+            if (colorCode != Color::FG_DEFAULT )
+                out << "\033[" << colorCode << "m";
+            (out << ... << items);
+            out << "\033[0m";
+        }
+
+        template<typename... T>
+        static void write_bold(std::ostream & out, Color::Code colorCode, std::string_view stamp, const T & ...items) {
+            if (colorCode != Color::FG_DEFAULT)
+                out << "\033[1m" <<"\033[" << colorCode << "m";
+            out << stamp;
+            (out << ... << items);
+            out << "\033[0m";
+        }
+
+        template<typename F>
+        static std::string format(F && formatter) {
+            thread_local std::ostringstream buffer;
+            buffer.str(std::string());
+            buffer.clear();
+            formatter(buffer);
+            return buffer.str();
+        }
+
+        void enqueue(async_sink & sink, std::string message) {
+            // Counted before the push so the flusher never subtracts bytes not yet added.
+            const std::size_t bytes = message.size();
+            pending_bytes.add(bytes);
+            while (not sink.ring.try_push(std::move(message))) {
+                if (sink.policy == overflow_policy::drop) {
+                    pending_bytes.sub(bytes);
+                    sink.dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                sink.wake_cv.notify_one();
+                std::this_thread::yield();
+            }
+            if (sink.sleeping.load(std::memory_order_acquire))
+                sink.wake_cv.notify_one();
+        }
+
+        void run_flusher(async_sink * sink) {
+            std::string batch;
+            std::string message;
+            while (true) {
+                std::uint64_t count = 0;
+                batch.clear();
+                while (sink->ring.try_pop(message)) {
+                    batch += message;
+                    ++count;
+                }
+                if (count != 0) {
+                    {
+                        const std::scoped_lock lock(stream_mutex);
+                        out_stream.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+                        out_stream.flush();
+                    }
+                    pending_bytes.sub(batch.size());
+                    const std::scoped_lock lock(sink->mutex);
+                    sink->written.fetch_add(count, std::memory_order_release);
+                    sink->flushed_cv.notify_all();
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(sink->mutex);
+                if (sink->stopping)
+                    return;
+                // A push racing with going to sleep is picked up at the latest by the timeout.
+                sink->sleeping.store(true, std::memory_order_release);
+                sink->wake_cv.wait_for(lock, std::chrono::milliseconds(10));
+                sink->sleeping.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        mutable PTPLib::threads::site_mutex<std::mutex> stream_mutex = PTPLib::threads::make_site_mutex<std::mutex>("synced_stream::stream_mutex");
         std::ostream & out_stream;
+        std::atomic<async_sink *> async = nullptr;
+        std::atomic<timestamp_mode> stamp_mode = timestamp_mode::seconds;
+        tracked_bytes pending_bytes;
+        std::unique_ptr<async_sink> sink_owner;
     };
 
     class PrintStopWatch {
@@ -11,9 +11,77 @@
 #include <string>
 #include <iostream>
 #include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
 
 namespace PTPLib::common {
 
+    // Integer ticks of the invariant time-stamp counter where the CPU has one, of steady_clock in nanoseconds otherwise.
+    // Reading it is a single instruction on x86; converting ticks to time calibrates the counter against steady_clock
+    // once per process, which takes a few milliseconds on first use.
+    class tick_clock {
+        static bool detect_invariant_tsc() {
+#if defined(__x86_64__) || defined(__i386__)
+            unsigned int eax, ebx, ecx, edx;
+            if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007)
+                return false;
+            __cpuid(0x80000007, eax, ebx, ecx, edx);
+            return edx & (1u << 8);
+#else
+            return false;
+#endif
+        }
+
+        static std::uint64_t steady_nanoseconds() {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        static std::uint64_t calibrate() {
+            if (not uses_tsc())
+                return 1000000000;
+            const std::uint64_t start_ns = steady_nanoseconds();
+            const std::uint64_t start_ticks = now();
+            std::uint64_t elapsed_ns;
+            do {
+                elapsed_ns = steady_nanoseconds() - start_ns;
+            } while (elapsed_ns < 5000000);
+            const std::uint64_t elapsed_ticks = now() - start_ticks;
+            return static_cast<std::uint64_t>(static_cast<long double>(elapsed_ticks) * 1e9L / elapsed_ns);
+        }
+
+    public:
+        typedef std::uint64_t ticks;
+
+        static bool uses_tsc() {
+            static const bool invariant_tsc = detect_invariant_tsc();
+            return invariant_tsc;
+        }
+
+        static ticks now() {
+#if defined(__x86_64__) || defined(__i386__)
+            if (uses_tsc())
+                return __rdtsc();
+#endif
+            return steady_nanoseconds();
+        }
+
+        static std::uint64_t ticks_per_second() {
+            static const std::uint64_t frequency = calibrate();
+            return frequency;
+        }
+
+        // Exact in 64 bits for any tick count and frequency below 18 GHz.
+        static std::uint64_t to_nanoseconds(ticks t) {
+            const std::uint64_t frequency = ticks_per_second();
+            return t / frequency * 1000000000 + t % frequency * 1000000000 / frequency;
+        }
+    };
+
 // A c++ wrapper for manual time checking
     class StoppableWatch {
 
@@ -30,8 +98,8 @@ namespace PTPLib::common {
 
         inline StoppableWatch( bool start = false) :
                 started_(false), paused_(false),
-                reference_( std::chrono::steady_clock::now()),
-                accumulated_(std::chrono::duration<long double>(0)) {
+                reference_(tick_clock::now()),
+                accumulated_(0) {
             if (start)
                 this->start();
         }
@@ -40,19 +108,17 @@ namespace PTPLib::common {
             if (not started_) {
                 started_ = true;
                 paused_ = false;
-                accumulated_ = std::chrono::duration<long double>(0);
-                reference_ = std::chrono::steady_clock::now();
+                accumulated_ = 0;
+                reference_ = tick_clock::now();
             } else if (paused_) {
-                reference_ = std::chrono::steady_clock::now();
+                reference_ = tick_clock::now();
                 paused_ = false;
             }
         }
 
         inline void stop() {
             if (started_ && not paused_) {
-                auto now = std::chrono::steady_clock::now();
-                accumulated_ = accumulated_ +
-                               std::chrono::duration_cast<std::chrono::duration<long double> >(now - reference_);
+                accumulated_ += tick_clock::now() - reference_;
                 paused_ = true;
             }
         }
@@ -61,42 +127,40 @@ namespace PTPLib::common {
             if (started_) {
                 started_ = false;
                 paused_ = false;
-                reference_ = std::chrono::steady_clock::now();
-                accumulated_ = std::chrono::duration<long double>(0);
+                reference_ = tick_clock::now();
+                accumulated_ = 0;
             }
         }
 
-        inline std::uint_fast16_t elapsed_time_microseconds() {
+        inline std::uint64_t elapsed_time_microseconds() const {
             return count_elapsed<std::chrono::microseconds>();
         }
 
-        inline std::uint_fast16_t elapsed_time_milliseconds() {
+        inline std::uint64_t elapsed_time_milliseconds() const {
             return count_elapsed<std::chrono::milliseconds>();
         }
 
-        inline std::uint_fast8_t elapsed_time_second() {
+        inline std::uint64_t elapsed_time_second() const {
             return count_elapsed<std::chrono::seconds>();
         }
 
+        inline tick_clock::ticks elapsed_ticks() const {
+            if (not started_)
+                return 0;
+            return paused_ ? accumulated_ : accumulated_ + (tick_clock::now() - reference_);
+        }
+
         template<class duration_t>
-        typename duration_t::rep count_elapsed() const {
-            if (started_) {
-                if (paused_) {
-                    return std::chrono::duration_cast<duration_t>(accumulated_).count();
-                } else {
-                    return std::chrono::duration_cast<duration_t>(
-                            accumulated_ + (std::chrono::steady_clock::now() - reference_)).count();
-                }
-            } else {
-                return duration_t(0).count();
-            }
+        std::uint64_t count_elapsed() const {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<duration_t>(
+                    std::chrono::nanoseconds(tick_clock::to_nanoseconds(elapsed_ticks()))).count());
         }
 
     private:
         bool started_;
         bool paused_;
-        std::chrono::steady_clock::time_point reference_;
-        std::chrono::duration<long double> accumulated_;
+        tick_clock::ticks reference_;
+        tick_clock::ticks accumulated_;
     };
 }
 #endif // PTPLIB_COMMON_TIMER_HPP
\ No newline at end of file
@@ -10,7 +10,12 @@
 
 #include "Header.hpp"
 #include "Lemma.hpp"
+#include "LemmaArena.hpp"
 #include "SMTSEvent.hpp"
+#include "PTPLib/common/Memory.hpp"
+#include "PTPLib/threads/ProfiledMutex.hpp"
+#include "PTPLib/threads/RingBuffer.hpp"
+#include "PTPLib/threads/StopToken.hpp"
 
 #include <vector>
 #include <mutex>
@@ -20,82 +25,224 @@
 #include <algorithm>
 #include <chrono>
 #include <deque>
+#include <functional>
+#include <iterator>
 #include <cassert>
+#include <cstdint>
+#include <type_traits>
 
 namespace PTPLib::net {
 
     using map_solverBranch_lemmas = std::map<std::string, std::vector<PTPLib::net::Lemma>>;
     using time_duration = std::chrono::duration<double>;
+    using channel_mutex = PTPLib::threads::site_mutex<std::mutex>;
 
     template <class EVENT, class LEMMA>
     class Channel {
 
-        std::mutex mutex;
-        std::condition_variable cv;
+        channel_mutex mutex = PTPLib::threads::make_site_mutex<std::mutex>("Channel::mutex");
+        std::conditional_t<std::is_same_v<channel_mutex, std::mutex>, std::condition_variable, std::condition_variable_any> cv;
 
         using queue_event = std::deque<EVENT>;
+        // std::map of lemma vectors per node, or for ArenaLemma one that also owns the arena of their clauses.
+        using lemma_map = typename lemma_traits<LEMMA>::map_type;
         queue_event events;
-        std::unique_ptr<map_solverBranch_lemmas> solverBranchToPublishLemmas;
-        std::unique_ptr<map_solverBranch_lemmas> solverBranchToPulledLemmas;
+        std::unique_ptr<lemma_map> solverBranchToPublishLemmas;
+        std::unique_ptr<lemma_map> solverBranchToPulledLemmas;
+        // A lemma in the ring, tagged with the epoch of the instance it was learned on.
+        struct published_lemma {
+            LEMMA lemma;
+            std::uint64_t epoch = 0;
+        };
+        PTPLib::threads::spsc_ring_buffer<published_lemma> publishedLemmas;
+        // Bumped by resetChannel(), so lemmas of the previous instance still in flight are dropped.
+        std::atomic<std::uint64_t> epoch;
+        PTPLib::common::tracked_bytes learned_bytes;
+        PTPLib::common::tracked_bytes pulled_bytes;
 
         PTPLib::net::Header current_header;
 
-        std::atomic_bool requestStop;
-        bool reset;
-        std::atomic_bool isStopping;
+    public:
+        // The control flags, kept together in one atomic state word.
+        enum state_flag : std::uint32_t {
+            STOP_REQUESTED  = 1u << 0,
+            RESET           = 1u << 1,
+            STOPPING        = 1u << 2,
+            CLAUSE_SHARE    = 1u << 3,
+            LEARN_CLAUSES   = 1u << 4,
+            PARALLEL_MODE   = 1u << 5,
+            COLOR_MODE      = 1u << 6,
+        };
+
+    private:
+        std::atomic<std::uint32_t> state;
+
+        std::mutex waiters_mutex;
+        std::atomic<std::size_t> waiter_count;
+        std::uint64_t next_waiter_id;
+        std::map<std::uint64_t, std::function<void()>> waiters;
+
+        PTPLib::threads::stop_source reset_source;
+
+        void wake_waiters() {
+            if (waiter_count.load(std::memory_order_acquire) == 0)
+                return;
+            std::map<std::uint64_t, std::function<void()>> woken;
+            {
+                const std::scoped_lock lock(waiters_mutex);
+                std::swap(woken, waiters);
+                waiter_count.store(0, std::memory_order_release);
+            }
+            for (auto & waiter : woken)
+                waiter.second();
+        }
+
+        // An estimate of the memory held by the lemmas in [first, last).
+        template<typename It>
+        static std::size_t lemma_bytes(It first, It last) {
+            std::size_t bytes = 0;
+            for (; first != last; ++first)
+                bytes += sizeof(LEMMA) + lemma_traits<LEMMA>::heap_bytes(*first);
+            return bytes;
+        }
+
+        // Appends the lemmas to a node of map; arena lemmas get their clause copied into the map's arena.
+        template<typename It>
+        static void append_lemmas(lemma_map & map, std::vector<LEMMA> & node_lemmas, It first, It last) {
+            if constexpr (lemma_traits<LEMMA>::uses_arena) {
+                node_lemmas.reserve(node_lemmas.size() + static_cast<std::size_t>(std::distance(first, last)));
+                for (; first != last; ++first)
+                    node_lemmas.push_back(map.adopt(*first));
+            }
+            else
+                node_lemmas.insert(std::end(node_lemmas), first, last);
+        }
 
-        bool clauseShareMode;
-        std::atomic_bool shouldLearnClause;
+        // Moves the lemmas published by the solver for this instance to the current node, dropping those published
+        // before the last resetChannel(); mutex must be held.
+        void drain_published_clauses() {
+            if (publishedLemmas.empty() or current_header.count(PTPLib::common::Param.NODE) == 0)
+                return;
+            auto & node_lemmas = (*solverBranchToPublishLemmas)[current_header.at(PTPLib::common::Param.NODE)];
+            const std::size_t drained_from = node_lemmas.size();
+            const std::uint64_t current = epoch.load(std::memory_order_relaxed);
+            publishedLemmas.consume_batch([&node_lemmas, current](published_lemma && published) {
+                if (published.epoch == current)
+                    node_lemmas.push_back(std::move(published.lemma));
+            });
+            learned_bytes.add(lemma_bytes(node_lemmas.begin() + drained_from, node_lemmas.end()));
+        }
 
-        bool parallel_mode;
-        bool color_mode;
+        void discard_published_clauses() {
+            publishedLemmas.consume_batch([](published_lemma &&) {});
+        }
 
     public:
-        Channel()
-        : requestStop(false)
-        , reset(false)
-        , isStopping(false)
-        , clauseShareMode(false)
-        , shouldLearnClause(true)
-        , parallel_mode(false)
-        , color_mode(false)
+        explicit Channel(std::size_t published_capacity = 4096)
+        : publishedLemmas(published_capacity)
+        , epoch(0)
+        , state(LEARN_CLAUSES)
+        , waiter_count(0)
+        , next_waiter_id(0)
         {
-            solverBranchToPublishLemmas = std::make_unique<map_solverBranch_lemmas>();
-            solverBranchToPulledLemmas = std::make_unique<map_solverBranch_lemmas>();
+            solverBranchToPublishLemmas = std::make_unique<lemma_map>();
+            solverBranchToPulledLemmas = std::make_unique<lemma_map>();
         }
 
-        std::mutex & getMutex() { return mutex; }
+        channel_mutex & getMutex() { return mutex; }
 
         void insert_learned_clause(std::vector<LEMMA> && toPublish_clauses) {
             assert(not get_current_header().empty());
-            (*solverBranchToPublishLemmas)[get_current_header().at(PTPLib::common::Param.NODE)].insert
-                    (
-                            std::end((*solverBranchToPublishLemmas)[get_current_header().at(PTPLib::common::Param.NODE)]),
-                            std::begin(toPublish_clauses), std::end(toPublish_clauses)
-                    );
+            drain_published_clauses();
+            learned_bytes.add(lemma_bytes(toPublish_clauses.begin(), toPublish_clauses.end()));
+            append_lemmas(*solverBranchToPublishLemmas,
+                          (*solverBranchToPublishLemmas)[get_current_header().at(PTPLib::common::Param.NODE)],
+                          std::begin(toPublish_clauses), std::end(toPublish_clauses));
         }
 
         void insert_pulled_clause(std::vector<LEMMA> && toInject_clauses) {
             assert(not get_current_header().empty());
-            (*solverBranchToPulledLemmas)[get_current_header().at(PTPLib::common::Param.NODE)].insert
-                    (
-                            std::end((*solverBranchToPulledLemmas)[get_current_header().at(PTPLib::common::Param.NODE)]),
-                            std::begin(toInject_clauses), std::end(toInject_clauses)
-                    );
+            pulled_bytes.add(lemma_bytes(toInject_clauses.begin(), toInject_clauses.end()));
+            append_lemmas(*solverBranchToPulledLemmas,
+                          (*solverBranchToPulledLemmas)[get_current_header().at(PTPLib::common::Param.NODE)],
+                          std::begin(toInject_clauses), std::end(toInject_clauses));
         }
 
-        std::unique_ptr<map_solverBranch_lemmas> swap_learned_clauses() {
-            auto out = std::make_unique<map_solverBranch_lemmas>();
+        // The instance the channel is on; a solver takes it when it starts on an instance and publishes with it.
+        std::uint64_t get_epoch() const { return epoch.load(std::memory_order_acquire); }
+
+        // The solver's lock-free path to publish learned lemmas for the current node: a single producer pushes them
+        // into a ring buffer drained under the mutex by swap_learned_clauses(). Only if the ring is full does it fall
+        // back to taking the mutex, so call it without holding the mutex. Arena lemmas always take the mutex, as their
+        // clauses are views into the caller's strings until copied into the buffer's arena. Lemmas of an epoch other
+        // than the channel's, i.e. learned before a resetChannel(), are dropped.
+        void publish_learned_clauses(std::vector<LEMMA> & toPublish_clauses, std::uint64_t learned_epoch) {
+            if constexpr (lemma_traits<LEMMA>::uses_arena) {
+                const std::scoped_lock lock(mutex);
+                if (learned_epoch == epoch.load(std::memory_order_relaxed))
+                    insert_learned_clause(std::move(toPublish_clauses));
+                toPublish_clauses.clear();
+                return;
+            }
+            auto rest = publishedLemmas.push_batch(toPublish_clauses.begin(), toPublish_clauses.end(), [learned_epoch](LEMMA && lemma) {
+                return published_lemma{std::move(lemma), learned_epoch};
+            });
+            if (rest != toPublish_clauses.end()) {
+                const std::scoped_lock lock(mutex);
+                drain_published_clauses();
+                if (learned_epoch == epoch.load(std::memory_order_relaxed)) {
+                    std::vector<LEMMA> overflow(std::make_move_iterator(rest), std::make_move_iterator(toPublish_clauses.end()));
+                    insert_learned_clause(std::move(overflow));
+                }
+            }
+            toPublish_clauses.clear();
+        }
+
+        void publish_learned_clauses(std::vector<LEMMA> & toPublish_clauses) {
+            publish_learned_clauses(toPublish_clauses, get_epoch());
+        }
+
+        // The swapped out buffer owns its lemmas' arena, if any, and frees it in one go when destroyed.
+        std::unique_ptr<lemma_map> swap_learned_clauses() {
+            drain_published_clauses();
+            auto out = std::make_unique<lemma_map>();
             std::swap(out, solverBranchToPublishLemmas);
+            learned_bytes.set(0);
             return out;
         };
 
-        std::unique_ptr<map_solverBranch_lemmas> swap_pulled_clauses() {
-            auto out = std::make_unique<map_solverBranch_lemmas>();
+        std::unique_ptr<lemma_map> swap_pulled_clauses() {
+            auto out = std::make_unique<lemma_map>();
             std::swap(out, solverBranchToPulledLemmas);
+            pulled_bytes.set(0);
             return out;
         };
 
+        // Drops pulled lemmas until at most keep_bytes are left, e.g. from a MemoryBudget callback; mutex must be held.
+        // Nodes are visited in the order of their names, not by when their lemmas arrived, and each node loses its
+        // earliest pulled lemmas first. Returns the bytes freed. Arena bytes are only given back once no pulled lemma
+        // is left.
+        std::size_t shed_pulled_clauses(std::size_t keep_bytes = 0) {
+            const std::size_t before = pulled_bytes.get();
+            std::size_t bytes = before;
+            for (auto it = solverBranchToPulledLemmas->begin(); it != solverBranchToPulledLemmas->end() and bytes > keep_bytes;) {
+                auto & lemmas = it->second;
+                auto last = lemmas.begin();
+                for (; last != lemmas.end() and bytes > keep_bytes; ++last)
+                    bytes -= std::min(bytes, lemma_bytes(last, std::next(last)));
+                lemmas.erase(lemmas.begin(), last);
+                it = lemmas.empty() ? solverBranchToPulledLemmas->erase(it) : std::next(it);
+            }
+            if (solverBranchToPulledLemmas->empty())
+                solverBranchToPulledLemmas->clear();
+            pulled_bytes.set(bytes);
+            return before - bytes;
+        }
+
+        const PTPLib::common::tracked_bytes & learned_clauses_memory() const { return learned_bytes; }
+
+        const PTPLib::common::tracked_bytes & pulled_clauses_memory() const { return pulled_bytes; }
+
         void clear_queries() {
             queue_event empty_q;
             std::swap(events, empty_q);
@@ -115,6 +262,8 @@ namespace PTPLib::net {
 
         std::string & front_event() { return events.front().header.at(PTPLib::common::Param.COMMAND); }
 
+        PTPLib::common::CommandId front_command() const { return events.front().command; }
+
         template <typename Arg>
         void push_back_event(Arg && event) {
             assert((not event.header.at(PTPLib::common::Param.NODE).empty()) and (not event.header.at(PTPLib::common::Param.NAME).empty()));
@@ -129,6 +278,7 @@ namespace PTPLib::net {
 
         void set_current_header(PTPLib::net::Header & hd) {
             assert((not hd.at(PTPLib::common::Param.NODE).empty()) and (not hd.at(PTPLib::common::Param.NAME).empty()));
+            drain_published_clauses();
             current_header = hd.copy(hd.keys());
         }
 
@@ -136,6 +286,7 @@ namespace PTPLib::net {
             assert((hd.count(PTPLib::common::Param.NODE) == 1) and
             ((hd.count(PTPLib::common::Param.NAME) == 1)) and
             ((hd.count(PTPLib::common::Param.QUERY) == 1)));
+            drain_published_clauses();
             current_header = hd.copy(keys);
         }
 
@@ -153,79 +304,128 @@ namespace PTPLib::net {
 
         auto end() const { return solverBranchToPublishLemmas->end(); }
 
-        void notify_one() { cv.notify_one(); }
+        void notify_one() {
+            cv.notify_one();
+            wake_waiters();
+        }
+
+        void notify_all() {
+            cv.notify_all();
+            wake_waiters();
+        }
+
+        // Registers a one-shot callback run by the next notify_one()/notify_all(), for waiters that cannot block on
+        // the condition variable (e.g. coroutines). Register while holding the channel mutex to avoid missing a wakeup.
+        std::uint64_t add_waiter(std::function<void()> waiter) {
+            const std::scoped_lock lock(waiters_mutex);
+            waiters.emplace(++next_waiter_id, std::move(waiter));
+            waiter_count.store(waiters.size(), std::memory_order_release);
+            return next_waiter_id;
+        }
+
+        void remove_waiter(std::uint64_t id) {
+            const std::scoped_lock lock(waiters_mutex);
+            waiters.erase(id);
+            waiter_count.store(waiters.size(), std::memory_order_release);
+        }
 
-        void notify_all() { cv.notify_all(); }
+        void clear_learned_clauses() {
+            solverBranchToPublishLemmas->clear();
+            learned_bytes.set(0);
+        }
 
-        void clear_learned_clauses() { solverBranchToPublishLemmas->clear(); }
+        void clear_pulled_clauses() {
+            solverBranchToPulledLemmas->clear();
+            pulled_bytes.set(0);
+        }
 
-        void clear_pulled_clauses() { solverBranchToPulledLemmas->clear(); }
+        bool empty_learned_clauses() const { return (solverBranchToPublishLemmas->empty() and publishedLemmas.empty()); }
 
-        bool empty_learned_clauses() const { return (solverBranchToPublishLemmas->empty()); }
+        bool shouldReset() const { return test(RESET); }
 
-        bool shouldReset() const { return reset; }
+        void setReset() {
+            transition(RESET, 0);
+            reset_source.request_stop();
+        }
 
-        void setReset() { reset = true; }
+        // Stopped by setReset() and renewed by resetChannel(): work scheduled with this token, e.g. timers on the
+        // ThreadPool, is cancelled as a group when the channel is reset.
+        PTPLib::threads::stop_token reset_token() const { return reset_source.get_token(); }
 
-        void clearReset() { reset = false; }
+        void clearReset() { transition(0, RESET); }
 
-        bool shouldStop() const { return requestStop; }
+        // Polled by the solver on every iteration, hence a single relaxed load.
+        bool shouldStop() const { return state.load(std::memory_order_relaxed) & STOP_REQUESTED; }
 
-        void setShouldStop() { requestStop = true; }
+        void setShouldStop() { transition(STOP_REQUESTED, 0); }
 
-        void clearShouldStop() { requestStop = false; }
+        void clearShouldStop() { transition(0, STOP_REQUESTED); }
 
-        bool shallStop() const { return isStopping; }
+        bool shallStop() const { return test(STOPPING); }
 
-        void setShallStop() { isStopping = true; }
+        void setShallStop() { transition(STOPPING, 0); }
 
-        void clearShallStop() { isStopping = false; }
+        void clearShallStop() { transition(0, STOPPING); }
 
-        bool isClauseShareMode() const { return clauseShareMode; }
+        bool isClauseShareMode() const { return test(CLAUSE_SHARE); }
 
-        void setClauseShareMode() { clauseShareMode = true; }
+        void setClauseShareMode() { transition(CLAUSE_SHARE, 0); }
 
-        void clearClauseShareMode() { clauseShareMode = false; }
+        void clearClauseShareMode() { transition(0, CLAUSE_SHARE); }
 
-        bool shouldLearnClauses() const { return shouldLearnClause; }
+        bool shouldLearnClauses() const { return test(LEARN_CLAUSES); }
 
-        void setShouldLearnClauses() { shouldLearnClause = true; }
+        void setShouldLearnClauses() { transition(LEARN_CLAUSES, 0); }
 
-        void clearShouldLearnClauses() { shouldLearnClause = false; }
+        void clearShouldLearnClauses() { transition(0, LEARN_CLAUSES); }
 
-        bool isSolverInParallelMode() const { return parallel_mode; }
+        bool isSolverInParallelMode() const { return test(PARALLEL_MODE); }
 
-        void setParallelMode() { parallel_mode = true; }
+        void setParallelMode() { transition(PARALLEL_MODE, 0); }
 
-        void clearParallelMode() { parallel_mode = false; }
+        void clearParallelMode() { transition(0, PARALLEL_MODE); }
 
-        bool isColorMode() const { return color_mode; }
+        bool isColorMode() const { return test(COLOR_MODE); }
 
-        void setColorMode() { color_mode = true; }
+        void setColorMode() { transition(COLOR_MODE, 0); }
 
-        void clearColorMode() { color_mode = false; }
+        void clearColorMode() { transition(0, COLOR_MODE); }
+
+        std::uint32_t get_state() const { return state.load(std::memory_order_acquire); }
+
+        bool test(std::uint32_t flags) const { return state.load(std::memory_order_acquire) & flags; }
+
+        // Sets and clears flags in one atomic step; returns the old state. Waiters on the flags block on the channel's
+        // condition variable, since they also wait for events or a timeout, so wake them with notify_one()/notify_all().
+        std::uint32_t transition(std::uint32_t set_flags, std::uint32_t clear_flags) {
+            std::uint32_t old = state.load(std::memory_order_relaxed);
+            while (not state.compare_exchange_weak(old, (old | set_flags) & ~clear_flags, std::memory_order_seq_cst,
+                                                   std::memory_order_relaxed)) {}
+            return old;
+        }
 
-        bool wait_for_reset(std::unique_lock<std::mutex> & lock, const time_duration & td) {
+        bool wait_for_reset(std::unique_lock<channel_mutex> & lock, const time_duration & td) {
             return cv.wait_for(lock, td, [&] {
                 return shouldReset();
             });
         }
 
-        void wait_event_solver_reset(std::unique_lock<std::mutex> & lock) {
+        void wait_event_solver_reset(std::unique_lock<channel_mutex> & lock) {
             cv.wait(lock, [&] {
                 return (shouldReset() or shallStop() or not isEmpty_event());
             });
         }
 
         void resetChannel() {
+            epoch.fetch_add(1, std::memory_order_release);
             clear_pulled_clauses();
+            discard_published_clauses();
             clear_learned_clauses();
             clear_current_header();
             if (not isEmpty_event())
                 clear_queries();
-            clearShouldStop();
-            clearShallStop();
-            clearReset();
+            transition(0, STOP_REQUESTED | STOPPING | RESET);
+            reset_source = PTPLib::threads::stop_source();
         }
 
     };
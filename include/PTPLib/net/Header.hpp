@@ -11,6 +11,7 @@
 
 #include "PTPLib/common/Lib.hpp"
 
+#include <algorithm>
 #include <array>
 #include <iomanip>
 #include <map>
@@ -164,15 +165,12 @@ namespace PTPLib::net {
         }
 
     public:
+        // A node path "[0, 1, 2, 3]" lists two entries per level below the root.
         uint8_t level() const {
-            std::string node;
-            try {
-                node = this->at(PTPLib::common::Param.NODE);
-            } catch (std::out_of_range &) {
-            }
-            node  % std::make_pair("[", "") % std::make_pair("]", "") % std::make_pair(" ", "");
-            auto v = split(node, ",");
-            return (uint8_t)(v.size() / 2);
+            auto node = this->find(PTPLib::common::Param.NODE);
+            if (node == this->end())
+                return 0;
+            return (uint8_t)((std::count(node->second.begin(), node->second.end(), ',') + 1) / 2);
         }
 
         PTPLib::net::Header copy(const std::vector <std::string> & keys) const {
@@ -11,13 +11,22 @@
 
 #include <vector>
 #include <sstream>
+#include <charconv>
+#include <map>
+#include <string>
+#include <string_view>
 
 
 namespace PTPLib::net {
     class Lemma {
     public:
         friend std::ostream &operator<<(std::ostream &stream, const Lemma &lemma) {
-            return stream << std::to_string(lemma.level) << " " << lemma.clause;
+            // Always decimal, as std::to_string wrote it; a set width still pads it through the stream.
+            char level[12];
+            const auto end = std::to_chars(level, level + sizeof(level), lemma.level).ptr;
+            if (stream.width() != 0)
+                return stream << std::string_view(level, end - level) << " " << lemma.clause;
+            return stream.write(level, end - level) << " " << lemma.clause;
         }
 
         friend std::istream &operator>>(std::istream &stream, Lemma &lemma) {
@@ -33,6 +42,24 @@ namespace PTPLib::net {
         std::string clause;
         int level;
     };
+
+    // How a Channel stores a lemma type: the map of lemma buffers per node, whether clause bytes are copied into an
+    // arena owned by the buffer, and an estimate of the heap bytes a lemma holds beyond sizeof(LEMMA).
+    template<typename LEMMA>
+    struct lemma_traits {
+        using map_type = std::map<std::string, std::vector<LEMMA>>;
+
+        static constexpr bool uses_arena = false;
+
+        static std::size_t heap_bytes(const LEMMA & lemma) { return clause_capacity(lemma, 0); }
+
+    private:
+        template<typename T>
+        static auto clause_capacity(const T & lemma, int) -> decltype(lemma.clause.capacity()) { return lemma.clause.capacity(); }
+
+        template<typename T>
+        static std::size_t clause_capacity(const T &, long) { return 0; }
+    };
 }
 
 #endif //PTPLIB_NET_LEMMA_H
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2022, Seyedmasoud Asadzadeh <seyedmasoud.asadzadeh@usi.ch>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PTPLIB_NET_LEMMAARENA_HPP
+#define PTPLIB_NET_LEMMAARENA_HPP
+
+#include "Lemma.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace PTPLib::net {
+
+    // A bump allocator for clause bytes: stores copy into fixed-size chunks and nothing is freed one by one. reset()
+    // drops every stored view at once and keeps the first chunk for reuse; the rest go back to the heap.
+    class LemmaArena {
+        struct chunk {
+            std::unique_ptr<char[]> data;
+            std::size_t size;
+        };
+
+        std::size_t chunk_size;
+        std::vector<chunk> chunks;
+        char * cursor = nullptr;
+        char * limit = nullptr;
+        std::size_t used = 0;
+
+        void add_chunk(std::size_t min_size) {
+            const std::size_t size = std::max(chunk_size, min_size);
+            chunks.push_back(chunk{std::unique_ptr<char[]>(new char[size]), size});
+            cursor = chunks.back().data.get();
+            limit = cursor + size;
+        }
+
+    public:
+        explicit LemmaArena(std::size_t _chunk_size = 64 * 1024) : chunk_size(_chunk_size) {}
+
+        // The source is left empty: it keeps no pointer into the chunks it handed over.
+        LemmaArena(LemmaArena && other) noexcept
+        : chunk_size(other.chunk_size)
+        , chunks(std::move(other.chunks))
+        , cursor(std::exchange(other.cursor, nullptr))
+        , limit(std::exchange(other.limit, nullptr))
+        , used(std::exchange(other.used, 0)) {
+            other.chunks.clear();
+        }
+
+        LemmaArena & operator=(LemmaArena && other) noexcept {
+            if (this != &other) {
+                chunk_size = other.chunk_size;
+                chunks = std::move(other.chunks);
+                other.chunks.clear();
+                cursor = std::exchange(other.cursor, nullptr);
+                limit = std::exchange(other.limit, nullptr);
+                used = std::exchange(other.used, 0);
+            }
+            return *this;
+        }
+
+        // The view stays valid until reset() or the arena is destroyed; moving the arena keeps it valid.
+        std::string_view store(std::string_view bytes) {
+            if (bytes.empty())
+                return std::string_view();
+            if (static_cast<std::size_t>(limit - cursor) < bytes.size())
+                add_chunk(bytes.size());
+            std::memcpy(cursor, bytes.data(), bytes.size());
+            const std::string_view stored(cursor, bytes.size());
+            cursor += bytes.size();
+            used += bytes.size();
+            return stored;
+        }
+
+        void reset() {
+            if (chunks.size() > 1)
+                chunks.erase(chunks.begin() + 1, chunks.end());
+            cursor = chunks.empty() ? nullptr : chunks.front().data.get();
+            limit = chunks.empty() ? nullptr : cursor + chunks.front().size;
+            used = 0;
+        }
+
+        std::size_t bytes_used() const { return used; }
+
+        std::size_t bytes_reserved() const {
+            std::size_t reserved = 0;
+            for (auto & c : chunks)
+                reserved += c.size;
+            return reserved;
+        }
+    };
+
+    // A lemma whose clause is a view: into the caller's string until a Channel inserts it, then into the arena of the
+    // Channel's buffer, so the clause must be used or copied before the buffer is cleared or destroyed.
+    class ArenaLemma {
+    public:
+        friend std::ostream &operator<<(std::ostream &stream, const ArenaLemma &lemma) {
+            // Always decimal, as std::to_string wrote it; a set width still pads it through the stream.
+            char level[12];
+            const auto end = std::to_chars(level, level + sizeof(level), lemma.level).ptr;
+            if (stream.width() != 0)
+                return stream << std::string_view(level, end - level) << " " << lemma.clause;
+            return stream.write(level, end - level) << " " << lemma.clause;
+        }
+
+        ArenaLemma(std::string_view c, const int l) : clause(c), level(l) {}
+
+        ArenaLemma() : ArenaLemma(std::string_view(), 0) {}
+
+        Lemma to_lemma() const { return Lemma(std::string(clause), level); }
+
+        std::string_view clause;
+        int level;
+    };
+
+    // The lemma buffer of a Channel of ArenaLemma: the lemmas per node and the arena holding their clauses. The arena
+    // goes along when the buffer is swapped out, and clear() empties both.
+    class arena_lemma_map : public std::map<std::string, std::vector<ArenaLemma>> {
+        LemmaArena arena;
+
+    public:
+        // A copy of lemma whose clause lives in this buffer's arena.
+        ArenaLemma adopt(const ArenaLemma & lemma) { return ArenaLemma(arena.store(lemma.clause), lemma.level); }
+
+        void clear() {
+            std::map<std::string, std::vector<ArenaLemma>>::clear();
+            arena.reset();
+        }
+
+        const LemmaArena & get_arena() const { return arena; }
+    };
+
+    template<>
+    struct lemma_traits<ArenaLemma> {
+        using map_type = arena_lemma_map;
+
+        static constexpr bool uses_arena = true;
+
+        static std::size_t heap_bytes(const ArenaLemma & lemma) { return lemma.clause.size(); }
+    };
+}
+
+#endif // PTPLIB_NET_LEMMAARENA_HPP
@@ -19,6 +19,9 @@ namespace PTPLib::net {
     struct SMTS_Event {
         PTPLib::net::Header header;
         std::string body;
+        // The header's command, parsed when the event is built so consumers can switch on it; call parse_command()
+        // after changing the command in the header.
+        PTPLib::common::CommandId command = PTPLib::common::CommandId::UNKNOWN;
 
         SMTS_Event() {}
 
@@ -26,22 +29,31 @@ namespace PTPLib::net {
         SMTS_Event(HD && hd, PL && str) {
             this->header = std::forward<HD>(hd);
             this->body = std::forward<PL>(str);
+            parse_command();
         }
 
         template <typename HD, typename PL>
         SMTS_Event(HD & hd, PL && str) {
             this->header = hd;
             this->body = std::forward<PL>(str);
+            parse_command();
         }
 
         SMTS_Event(PTPLib::net::Header & hd) {
             this->header = hd;
             this->body = std::string();
+            parse_command();
         }
 
         SMTS_Event(PTPLib::net::Header && hd) {
             this->header = std::move(hd);
             this->body = std::string();
+            parse_command();
+        }
+
+        void parse_command() {
+            auto it = header.find(PTPLib::common::Param.COMMAND);
+            command = it == header.end() ? PTPLib::common::CommandId::UNKNOWN : PTPLib::common::command_id(it->second);
         }
 
         bool empty() const { return header.empty(); }
@@ -0,0 +1,340 @@
+/*
+ * Copyright (c) 2022, Seyedmasoud Asadzadeh <seyedmasoud.asadzadeh@usi.ch>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PTPLIB_THREADS_COROUTINE_HPP
+#define PTPLIB_THREADS_COROUTINE_HPP
+
+#if __cplusplus < 202002L || not __has_include(<coroutine>)
+#error "PTPLib coroutines require C++20, configure PTPLib with -DPTPLIB_ENABLE_CXX20=ON"
+#endif
+
+#include "PTPLib/threads/ThreadPool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace PTPLib::threads {
+
+    template<typename T = void>
+    class task;
+
+    namespace detail {
+        template<typename T>
+        struct task_promise_base {
+            std::coroutine_handle<> continuation = std::noop_coroutine();
+            std::exception_ptr error;
+
+            struct final_awaiter {
+                bool await_ready() noexcept { return false; }
+
+                template<typename P>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) noexcept {
+                    return handle.promise().continuation;
+                }
+
+                void await_resume() noexcept {}
+            };
+
+            std::suspend_always initial_suspend() noexcept { return {}; }
+
+            final_awaiter final_suspend() noexcept { return {}; }
+
+            void unhandled_exception() { error = std::current_exception(); }
+        };
+
+        template<typename T>
+        struct task_promise : task_promise_base<T> {
+            std::optional<T> value;
+
+            task<T> get_return_object();
+
+            template<typename V>
+            void return_value(V && v) { value.emplace(std::forward<V>(v)); }
+
+            T result() {
+                if (this->error)
+                    std::rethrow_exception(this->error);
+                return std::move(*value);
+            }
+        };
+
+        template<>
+        struct task_promise<void> : task_promise_base<void> {
+            task<void> get_return_object();
+
+            void return_void() {}
+
+            void result() {
+                if (this->error)
+                    std::rethrow_exception(this->error);
+            }
+        };
+
+        struct detached_task {
+            struct promise_type {
+                detached_task get_return_object() { return {}; }
+
+                std::suspend_never initial_suspend() noexcept { return {}; }
+
+                std::suspend_never final_suspend() noexcept { return {}; }
+
+                void return_void() {}
+
+                void unhandled_exception() { std::terminate(); }
+            };
+        };
+
+        // Resumes a suspended coroutine on the pool exactly once, whichever of its wakeup sources fires first.
+        // A wakeup may fire before await_suspend finished; arm() then reports it so the coroutine does not suspend.
+        struct resume_once {
+            ThreadPool & pool;
+            std::coroutine_handle<> handle;
+            std::atomic<bool> fired = false;
+            std::atomic<int> steps = 0;
+
+            resume_once(ThreadPool & _pool, std::coroutine_handle<> _handle) : pool(_pool), handle(_handle) {}
+
+            void fire() {
+                if (not fired.exchange(true) and steps.fetch_add(1, std::memory_order_acq_rel) == 1)
+                    pool.push_task([h = handle] { h.resume(); });
+            }
+
+            bool arm() { return steps.fetch_add(1, std::memory_order_acq_rel) == 1; }
+        };
+
+        // The deadline of a whole wait, served by one wheel timer: when it expires it wakes whichever suspension of the
+        // wait is current, and every later one does not suspend at all.
+        struct deadline_waker {
+            std::mutex mutex;
+            std::shared_ptr<resume_once> current;
+            bool expired = false;
+
+            void expire() {
+                std::shared_ptr<resume_once> waker;
+                {
+                    const std::scoped_lock lock(mutex);
+                    expired = true;
+                    waker = std::move(current);
+                }
+                if (waker)
+                    waker->fire();
+            }
+
+            // Returns false if the deadline has passed already.
+            bool watch(std::shared_ptr<resume_once> waker) {
+                const std::scoped_lock lock(mutex);
+                if (expired)
+                    return false;
+                current = std::move(waker);
+                return true;
+            }
+
+            bool has_expired() {
+                const std::scoped_lock lock(mutex);
+                return expired;
+            }
+        };
+
+        // Suspends until the channel is notified or the deadline, if any, passes; yields whether pred holds afterwards.
+        template<typename CHANNEL, typename PRED>
+        struct channel_awaiter {
+            ThreadPool & pool;
+            CHANNEL & channel;
+            PRED pred;
+            std::shared_ptr<deadline_waker> deadline;
+            std::uint64_t waiter_id = 0;
+
+            channel_awaiter(ThreadPool & _pool, CHANNEL & _channel, PRED _pred, std::shared_ptr<deadline_waker> _deadline)
+            : pool(_pool), channel(_channel), pred(std::move(_pred)), deadline(std::move(_deadline)) {}
+
+            bool await_ready() { return false; }
+
+            bool await_suspend(std::coroutine_handle<> handle) {
+                const std::scoped_lock lock(channel.getMutex());
+                if (pred())
+                    return false;
+                auto waker = std::make_shared<resume_once>(pool, handle);
+                waiter_id = channel.add_waiter([waker] { waker->fire(); });
+                if (deadline and not deadline->watch(waker))
+                    waker->fire();
+                return not waker->arm();
+            }
+
+            bool await_resume() {
+                if (waiter_id != 0)
+                    channel.remove_waiter(waiter_id);
+                const std::scoped_lock lock(channel.getMutex());
+                return pred();
+            }
+        };
+    }
+
+    // A lazily started coroutine producing a T. Awaiting it starts it on the awaiting thread and resumes the
+    // awaiting coroutine when it finishes; use co_spawn() to run a top-level task on a ThreadPool.
+    template<typename T>
+    class task {
+    public:
+        typedef detail::task_promise<T> promise_type;
+
+        explicit task(std::coroutine_handle<promise_type> _handle) : handle(_handle) {}
+
+        task(task && other) noexcept : handle(std::exchange(other.handle, {})) {}
+
+        task & operator=(task && other) noexcept {
+            if (this != &other) {
+                if (handle)
+                    handle.destroy();
+                handle = std::exchange(other.handle, {});
+            }
+            return *this;
+        }
+
+        task(const task &) = delete;
+
+        task & operator=(const task &) = delete;
+
+        ~task() {
+            if (handle)
+                handle.destroy();
+        }
+
+        bool await_ready() const noexcept { return false; }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+            handle.promise().continuation = awaiting;
+            return handle;
+        }
+
+        T await_resume() { return handle.promise().result(); }
+
+    private:
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    namespace detail {
+        template<typename T>
+        task<T> task_promise<T>::get_return_object() {
+            return task<T>(std::coroutine_handle<task_promise<T>>::from_promise(*this));
+        }
+
+        inline task<void> task_promise<void>::get_return_object() {
+            return task<void>(std::coroutine_handle<task_promise<void>>::from_promise(*this));
+        }
+    }
+
+    // co_await schedule(pool) continues the coroutine on one of the pool's workers.
+    inline auto schedule(ThreadPool & pool) {
+        struct awaiter {
+            ThreadPool & pool;
+
+            bool await_ready() const noexcept { return false; }
+
+            void await_suspend(std::coroutine_handle<> handle) { pool.push_task([handle] { handle.resume(); }); }
+
+            void await_resume() const noexcept {}
+        };
+        return awaiter{pool};
+    }
+
+    // Suspends the coroutine without holding a thread and continues it on the pool once the duration elapsed.
+    template<typename Rep, typename Period>
+    auto sleep_for(ThreadPool & pool, std::chrono::duration<Rep, Period> duration) {
+        struct awaiter {
+            ThreadPool & pool;
+            std::chrono::steady_clock::time_point deadline;
+
+            bool await_ready() const noexcept { return deadline <= std::chrono::steady_clock::now(); }
+
+            void await_suspend(std::coroutine_handle<> handle) {
+                pool.schedule_after(deadline - std::chrono::steady_clock::now(), [handle] { handle.resume(); });
+            }
+
+            void await_resume() const noexcept {}
+        };
+        return awaiter{pool, std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(duration)};
+    }
+
+    // Completes once the channel has an event to process, a reset was signalled or the solver shall stop,
+    // i.e. the predicate of Channel::wait_event_solver_reset.
+    template<typename CHANNEL>
+    task<> next_event(ThreadPool & pool, CHANNEL & channel) {
+        auto pred = [&channel] { return channel.shouldReset() or channel.shallStop() or not channel.isEmpty_event(); };
+        while (not co_await detail::channel_awaiter<CHANNEL, decltype(pred)>{pool, channel, pred, nullptr}) {}
+    }
+
+    template<typename CHANNEL>
+    task<> reset_signalled(ThreadPool & pool, CHANNEL & channel) {
+        auto pred = [&channel] { return channel.shouldReset(); };
+        while (not co_await detail::channel_awaiter<CHANNEL, decltype(pred)>{pool, channel, pred, nullptr}) {}
+    }
+
+    // The coroutine counterpart of Channel::wait_for_reset: yields true if a reset was signalled before the timeout.
+    // Spurious wakeups suspend again under the same timer.
+    template<typename CHANNEL, typename Rep, typename Period>
+    task<bool> wait_for_reset(ThreadPool & pool, CHANNEL & channel, std::chrono::duration<Rep, Period> timeout) {
+        auto deadline = std::make_shared<detail::deadline_waker>();
+        timer_handle timer = pool.get_timer_wheel().schedule_after(
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout), [deadline] { deadline->expire(); });
+        auto pred = [&channel] { return channel.shouldReset(); };
+        while (true) {
+            if (co_await detail::channel_awaiter<CHANNEL, decltype(pred)>{pool, channel, pred, deadline}) {
+                timer.cancel();
+                co_return true;
+            }
+            if (deadline->has_expired())
+                co_return false;
+        }
+    }
+
+    // std::future offers no continuation, so readiness is polled with a backoff growing from one timer tick (1ms)
+    // up to max_interval.
+    template<typename FUTURE>
+    task<> when_ready(ThreadPool & pool, FUTURE & future, std::chrono::microseconds max_interval = std::chrono::milliseconds(10)) {
+        std::chrono::microseconds interval(1000);
+        while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            co_await sleep_for(pool, interval);
+            interval = std::min(interval * 2, max_interval);
+        }
+    }
+
+    namespace detail {
+        template<typename T>
+        detached_task run_detached(ThreadPool & pool, task<T> t, std::promise<T> promise) {
+            co_await schedule(pool);
+            try {
+                if constexpr (std::is_void_v<T>) {
+                    co_await std::move(t);
+                    promise.set_value();
+                }
+                else
+                    promise.set_value(co_await std::move(t));
+            }
+            catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+        }
+    }
+
+    // Starts the task on the pool. While suspended, a coroutine does not count as a pool task, so wait on the
+    // returned future rather than on ThreadPool::wait_for_tasks().
+    template<typename T>
+    std::future<T> co_spawn(ThreadPool & pool, task<T> t) {
+        std::promise<T> promise;
+        std::future<T> future = promise.get_future();
+        detail::run_detached(pool, std::move(t), std::move(promise));
+        return future;
+    }
+}
+
+#endif // PTPLIB_THREADS_COROUTINE_HPP
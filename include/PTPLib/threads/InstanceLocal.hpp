@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2022, Seyedmasoud Asadzadeh <seyedmasoud.asadzadeh@usi.ch>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PTPLIB_THREADS_INSTANCELOCAL_HPP
+#define PTPLIB_THREADS_INSTANCELOCAL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace PTPLib::threads {
+
+    // Ids of objects that keep per-thread state, e.g. a TaskTracer's buffer of every recording thread. Ids are never
+    // reused; releasing one bumps an epoch, so threads drop their entries of dead objects on their next lookup.
+    class instance_ids {
+        static std::mutex & ids_mutex() {
+            static std::mutex mutex;
+            return mutex;
+        }
+
+        static std::unordered_set<std::uint64_t> & live() {
+            static std::unordered_set<std::uint64_t> ids;
+            return ids;
+        }
+
+    public:
+        static std::atomic<std::uint64_t> & epoch() {
+            static std::atomic<std::uint64_t> counter = 0;
+            return counter;
+        }
+
+        static std::uint64_t acquire() {
+            static std::atomic<std::uint64_t> counter = 0;
+            const std::uint64_t id = ++counter;
+            const std::scoped_lock lock(ids_mutex());
+            live().insert(id);
+            return id;
+        }
+
+        static void release(std::uint64_t id) {
+            {
+                const std::scoped_lock lock(ids_mutex());
+                live().erase(id);
+            }
+            epoch().fetch_add(1, std::memory_order_release);
+        }
+
+        static bool is_live(std::uint64_t id) {
+            const std::scoped_lock lock(ids_mutex());
+            return live().count(id) != 0;
+        }
+    };
+
+    // A thread's entries for the objects it has state for, keyed by instance id; declare it thread_local. The state
+    // itself is owned by the object, the entry only points to it.
+    template<typename T>
+    class instance_local {
+        std::vector<std::pair<std::uint64_t, T *>> entries;
+        std::uint64_t seen_epoch = 0;
+
+    public:
+        T * find(std::uint64_t id) {
+            const std::uint64_t epoch = instance_ids::epoch().load(std::memory_order_acquire);
+            if (epoch != seen_epoch) {
+                seen_epoch = epoch;
+                entries.erase(std::remove_if(entries.begin(), entries.end(), [](const std::pair<std::uint64_t, T *> & entry) {
+                    return not instance_ids::is_live(entry.first);
+                }), entries.end());
+            }
+            for (auto & entry : entries) {
+                if (entry.first == id)
+                    return entry.second;
+            }
+            return nullptr;
+        }
+
+        void insert(std::uint64_t id, T * state) { entries.emplace_back(id, state); }
+
+        std::size_t size() const { return entries.size(); }
+    };
+}
+
+#endif // PTPLIB_THREADS_INSTANCELOCAL_HPP
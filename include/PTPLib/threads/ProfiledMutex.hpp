@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2022, Seyedmasoud Asadzadeh <seyedmasoud.asadzadeh@usi.ch>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PTPLIB_THREADS_PROFILEDMUTEX_HPP
+#define PTPLIB_THREADS_PROFILEDMUTEX_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace PTPLib::threads {
+
+    // Contention counters of one mutex site, shared by every mutex constructed with the same site name.
+    struct mutex_site_stats {
+        std::atomic<std::uint64_t> acquisitions = 0;
+        std::atomic<std::uint64_t> contended = 0;
+        std::atomic<std::uint64_t> wait_ns = 0;
+        std::atomic<std::uint64_t> max_wait_ns = 0;
+        std::atomic<std::uint64_t> hold_ns = 0;
+
+        void reset() {
+            acquisitions = 0;
+            contended = 0;
+            wait_ns = 0;
+            max_wait_ns = 0;
+            hold_ns = 0;
+        }
+    };
+
+    class lock_profiler {
+        std::mutex registry_mutex;
+        std::map<std::string, std::unique_ptr<mutex_site_stats>> sites;
+
+    public:
+        static lock_profiler & instance() {
+            static lock_profiler profiler;
+            return profiler;
+        }
+
+        mutex_site_stats & site(const std::string & name) {
+            const std::scoped_lock lock(registry_mutex);
+            auto & stats = sites[name];
+            if (not stats)
+                stats = std::make_unique<mutex_site_stats>();
+            return *stats;
+        }
+
+        void reset() {
+            const std::scoped_lock lock(registry_mutex);
+            for (auto & site : sites)
+                site.second->reset();
+        }
+
+        // One line per site, the site with the most time spent waiting first.
+        void write_report(std::ostream & stream) {
+            const std::scoped_lock lock(registry_mutex);
+            std::vector<std::pair<std::string, const mutex_site_stats *>> ranked;
+            for (auto & site : sites)
+                ranked.emplace_back(site.first, site.second.get());
+            std::sort(ranked.begin(), ranked.end(), [](const auto & a, const auto & b) {
+                return a.second->wait_ns.load() > b.second->wait_ns.load();
+            });
+            stream << std::left << std::setw(32) << "site" << std::right << std::setw(14) << "acquisitions"
+                   << std::setw(12) << "contended" << std::setw(14) << "wait ms" << std::setw(14) << "max wait us"
+                   << std::setw(14) << "hold ms" << '\n';
+            for (auto & site : ranked) {
+                const mutex_site_stats & stats = *site.second;
+                stream << std::left << std::setw(32) << site.first << std::right
+                       << std::setw(14) << stats.acquisitions.load()
+                       << std::setw(12) << stats.contended.load()
+                       << std::setw(14) << std::fixed << std::setprecision(3) << stats.wait_ns.load() / 1e6
+                       << std::setw(14) << stats.max_wait_ns.load() / 1e3
+                       << std::setw(14) << stats.hold_ns.load() / 1e6 << '\n';
+            }
+            stream << std::defaultfloat;
+        }
+    };
+
+    // A mutex that records acquisitions, contended acquisitions, wait and hold time into its site's stats.
+    // It derives from M so it still binds to M & (e.g. std::unique_lock<std::mutex>), but locks taken through the
+    // base class are not recorded. Not meant for recursive mutexes: hold time assumes a single owner.
+    template<typename M = std::mutex>
+    class profiled_mutex : public M {
+        typedef std::chrono::steady_clock clock;
+
+        mutex_site_stats & stats;
+        clock::time_point acquired_at;
+
+        void acquired(clock::time_point now) {
+            acquired_at = now;
+            stats.acquisitions.fetch_add(1, std::memory_order_relaxed);
+        }
+
+    public:
+        explicit profiled_mutex(const std::string & site = "unnamed")
+        : stats(lock_profiler::instance().site(site)) {}
+
+        void lock() {
+            if (M::try_lock()) {
+                acquired(clock::now());
+                return;
+            }
+            const clock::time_point start = clock::now();
+            M::lock();
+            const clock::time_point now = clock::now();
+            const auto waited = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count());
+            stats.contended.fetch_add(1, std::memory_order_relaxed);
+            stats.wait_ns.fetch_add(waited, std::memory_order_relaxed);
+            std::uint64_t max_wait = stats.max_wait_ns.load(std::memory_order_relaxed);
+            while (max_wait < waited and not stats.max_wait_ns.compare_exchange_weak(max_wait, waited, std::memory_order_relaxed)) {}
+            acquired(now);
+        }
+
+        bool try_lock() {
+            if (not M::try_lock())
+                return false;
+            acquired(clock::now());
+            return true;
+        }
+
+        void unlock() {
+            const auto held = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - acquired_at).count();
+            stats.hold_ns.fetch_add(static_cast<std::uint64_t>(held), std::memory_order_relaxed);
+            M::unlock();
+        }
+
+        const mutex_site_stats & get_stats() const { return stats; }
+    };
+
+    // Library mutexes are declared as site_mutex<M> and initialised with make_site_mutex<M>("Class::member").
+    // Defining PTPLIB_PROFILE_LOCKS turns them into profiled_mutex<M>; otherwise they are plain M at no cost.
+#ifdef PTPLIB_PROFILE_LOCKS
+    template<typename M>
+    using site_mutex = profiled_mutex<M>;
+
+    template<typename M>
+    site_mutex<M> make_site_mutex(const char * site) { return site_mutex<M>(site); }
+#else
+    template<typename M>
+    using site_mutex = M;
+
+    template<typename M>
+    site_mutex<M> make_site_mutex(const char *) { return site_mutex<M>(); }
+#endif
+}
+
+#endif // PTPLIB_THREADS_PROFILEDMUTEX_HPP
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2022, Seyedmasoud Asadzadeh <seyedmasoud.asadzadeh@usi.ch>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PTPLIB_THREADS_RINGBUFFER_HPP
+#define PTPLIB_THREADS_RINGBUFFER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace PTPLib::threads {
+
+    inline constexpr std::size_t cache_line_size = 64;
+
+    // A bounded lock-free ring buffer for exactly one producer thread and one consumer thread at a time; consumers
+    // taking turns must be ordered by other means, e.g. a mutex. The indices live on separate cache lines and each side
+    // caches the other side's index, so a push or a pop touches the shared lines only when the cached view runs out.
+    template<typename T>
+    class spsc_ring_buffer {
+        const std::size_t mask;
+        std::unique_ptr<T[]> slots;
+
+        alignas(cache_line_size) std::atomic<std::size_t> head = 0;
+        std::size_t cached_tail = 0;
+
+        alignas(cache_line_size) std::atomic<std::size_t> tail = 0;
+        std::size_t cached_head = 0;
+
+        static std::size_t round_up(std::size_t capacity) {
+            std::size_t size = 2;
+            while (size < capacity)
+                size <<= 1;
+            return size;
+        }
+
+        // Free slots from the producer's view, refreshing the cached head only when the cached view is full.
+        std::size_t free_slots(std::size_t wanted, std::size_t t) {
+            std::size_t free = capacity() - (t - cached_head);
+            if (free < wanted) {
+                cached_head = head.load(std::memory_order_acquire);
+                free = capacity() - (t - cached_head);
+            }
+            return free;
+        }
+
+        std::size_t used_slots(std::size_t wanted, std::size_t h) {
+            std::size_t used = cached_tail - h;
+            if (used < wanted) {
+                cached_tail = tail.load(std::memory_order_acquire);
+                used = cached_tail - h;
+            }
+            return used;
+        }
+
+    public:
+        // The capacity is rounded up to a power of two.
+        explicit spsc_ring_buffer(std::size_t _capacity)
+        : mask(round_up(_capacity) - 1)
+        , slots(new T[mask + 1]) {}
+
+        spsc_ring_buffer(const spsc_ring_buffer &) = delete;
+
+        spsc_ring_buffer & operator=(const spsc_ring_buffer &) = delete;
+
+        std::size_t capacity() const { return mask + 1; }
+
+        // Producer side.
+        template<typename Arg>
+        bool try_push(Arg && value) {
+            const std::size_t t = tail.load(std::memory_order_relaxed);
+            if (free_slots(1, t) == 0)
+                return false;
+            slots[t & mask] = std::forward<Arg>(value);
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Producer side: moves from [first, last) until the buffer is full and returns the iterator past the last
+        // element moved, publishing them all with a single release store.
+        template<typename It>
+        It push_batch(It first, It last) {
+            return push_batch(first, last, [](auto && value) -> decltype(auto) { return std::move(value); });
+        }
+
+        // As above, storing convert(std::move(*it)) for each element, e.g. to tag it.
+        template<typename It, typename CONVERT>
+        It push_batch(It first, It last, CONVERT convert) {
+            const std::size_t t = tail.load(std::memory_order_relaxed);
+            const std::size_t free = free_slots(static_cast<std::size_t>(std::distance(first, last)), t);
+            std::size_t n = 0;
+            for (; first != last and n < free; ++first, ++n)
+                slots[(t + n) & mask] = convert(std::move(*first));
+            if (n != 0)
+                tail.store(t + n, std::memory_order_release);
+            return first;
+        }
+
+        // Consumer side.
+        bool try_pop(T & value) {
+            const std::size_t h = head.load(std::memory_order_relaxed);
+            if (used_slots(1, h) == 0)
+                return false;
+            value = std::move(slots[h & mask]);
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer side: moves up to max_count elements to out and returns how many were moved.
+        template<typename OutputIt>
+        std::size_t pop_batch(OutputIt out, std::size_t max_count = std::size_t(-1)) {
+            return consume_batch([&out](T && value) { *out++ = std::move(value); }, max_count);
+        }
+
+        // Consumer side: passes up to max_count elements to consume as rvalues and returns how many were taken.
+        template<typename CONSUME>
+        std::size_t consume_batch(CONSUME consume, std::size_t max_count = std::size_t(-1)) {
+            const std::size_t h = head.load(std::memory_order_relaxed);
+            const std::size_t n = std::min(used_slots(capacity(), h), max_count);
+            for (std::size_t i = 0; i < n; ++i)
+                consume(std::move(slots[(h + i) & mask]));
+            if (n != 0)
+                head.store(h + n, std::memory_order_release);
+            return n;
+        }
+
+        // Only a snapshot while the other side is active.
+        std::size_t size() const {
+            const std::size_t h = head.load(std::memory_order_acquire);
+            return tail.load(std::memory_order_acquire) - h;
+        }
+
+        bool empty() const { return size() == 0; }
+    };
+
+    // A bounded lock-free ring buffer for any number of producers and one consumer. Every slot carries a sequence
+    // number telling whose turn it is, so producers only contend on the tail index and never wait for each other.
+    template<typename T>
+    class mpsc_ring_buffer {
+        struct cell {
+            std::atomic<std::size_t> sequence;
+            T value;
+        };
+
+        const std::size_t mask;
+        std::unique_ptr<cell[]> cells;
+
+        alignas(cache_line_size) std::atomic<std::size_t> tail = 0;
+
+        alignas(cache_line_size) std::size_t head = 0;
+
+    public:
+        // The capacity is rounded up to a power of two.
+        explicit mpsc_ring_buffer(std::size_t _capacity)
+        : mask([_capacity] {
+            std::size_t size = 2;
+            while (size < _capacity)
+                size <<= 1;
+            return size - 1;
+        }())
+        , cells(new cell[mask + 1]) {
+            for (std::size_t i = 0; i <= mask; ++i)
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        mpsc_ring_buffer(const mpsc_ring_buffer &) = delete;
+
+        mpsc_ring_buffer & operator=(const mpsc_ring_buffer &) = delete;
+
+        std::size_t capacity() const { return mask + 1; }
+
+        // Producer side; value is left untouched when the buffer is full.
+        template<typename Arg>
+        bool try_push(Arg && value) {
+            std::size_t pos = tail.load(std::memory_order_relaxed);
+            cell * c;
+            while (true) {
+                c = &cells[pos & mask];
+                const std::size_t seq = c->sequence.load(std::memory_order_acquire);
+                if (seq == pos) {
+                    if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (seq < pos)
+                    return false;
+                else
+                    pos = tail.load(std::memory_order_relaxed);
+            }
+            c->value = std::forward<Arg>(value);
+            c->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Slots claimed by producers so far, the ones still being written included: once this many values were popped,
+        // every push that returned before the call has been consumed.
+        std::size_t claimed() const { return tail.load(std::memory_order_acquire); }
+
+        // Consumer side.
+        bool try_pop(T & value) {
+            cell & c = cells[head & mask];
+            if (c.sequence.load(std::memory_order_acquire) != head + 1)
+                return false;
+            value = std::move(c.value);
+            c.sequence.store(head + mask + 1, std::memory_order_release);
+            ++head;
+            return true;
+        }
+    };
+}
+
+#endif // PTPLIB_THREADS_RINGBUFFER_HPP
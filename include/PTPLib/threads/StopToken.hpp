@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2022, Seyedmasoud Asadzadeh <seyedmasoud.asadzadeh@usi.ch>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PTPLIB_THREADS_STOPTOKEN_HPP
+#define PTPLIB_THREADS_STOPTOKEN_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace PTPLib::threads {
+
+    // A C++17 counterpart of std::stop_source / std::stop_token / std::stop_callback.
+    // Callbacks run on the thread that requests the stop, or immediately on registration if a stop was already requested.
+    class stop_state {
+        std::atomic<bool> requested = false;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::list<std::pair<std::uint64_t, std::function<void()>>> callbacks;
+        std::uint64_t next_id = 0;
+        std::uint64_t running_id = 0;
+        std::thread::id running_thread;
+
+        friend class stop_source;
+        friend class stop_token;
+        friend class stop_callback;
+
+        bool request_stop() {
+            if (requested.exchange(true))
+                return false;
+            std::unique_lock<std::mutex> lock(mutex);
+            while (not callbacks.empty()) {
+                auto callback = std::move(callbacks.front());
+                callbacks.pop_front();
+                running_id = callback.first;
+                running_thread = std::this_thread::get_id();
+                lock.unlock();
+                callback.second();
+                lock.lock();
+                running_id = 0;
+                cv.notify_all();
+            }
+            return true;
+        }
+
+        bool stop_requested() const { return requested.load(std::memory_order_acquire); }
+    };
+
+    class stop_token {
+        std::shared_ptr<stop_state> state;
+
+        friend class stop_source;
+        friend class stop_callback;
+
+        explicit stop_token(std::shared_ptr<stop_state> _state) : state(std::move(_state)) {}
+
+    public:
+        stop_token() = default;
+
+        bool stop_possible() const { return state != nullptr; }
+
+        bool stop_requested() const { return state and state->stop_requested(); }
+    };
+
+    class stop_source {
+        std::shared_ptr<stop_state> state;
+
+    public:
+        stop_source() : state(std::make_shared<stop_state>()) {}
+
+        stop_token get_token() const { return stop_token(state); }
+
+        bool stop_requested() const { return state->stop_requested(); }
+
+        // Returns false if a stop had already been requested; otherwise runs every registered callback before returning.
+        bool request_stop() { return state->request_stop(); }
+    };
+
+    class stop_callback {
+        std::shared_ptr<stop_state> state;
+        std::uint64_t id = 0;
+
+    public:
+        template<typename F>
+        stop_callback(const stop_token & token, F && callback) : state(token.state) {
+            if (not state)
+                return;
+            {
+                const std::scoped_lock lock(state->mutex);
+                if (not state->stop_requested()) {
+                    id = ++state->next_id;
+                    state->callbacks.emplace_back(id, std::forward<F>(callback));
+                    return;
+                }
+            }
+            callback();
+        }
+
+        // Deregisters the callback; if it is running on another thread, waits for it to return.
+        ~stop_callback() {
+            if (not state or id == 0)
+                return;
+            std::unique_lock<std::mutex> lock(state->mutex);
+            for (auto it = state->callbacks.begin(); it != state->callbacks.end(); ++it) {
+                if (it->first == id) {
+                    state->callbacks.erase(it);
+                    return;
+                }
+            }
+            if (state->running_thread != std::this_thread::get_id())
+                state->cv.wait(lock, [this] { return state->running_id != id; });
+        }
+
+        stop_callback(const stop_callback &) = delete;
+
+        stop_callback & operator=(const stop_callback &) = delete;
+    };
+}
+
+#endif // PTPLIB_THREADS_STOPTOKEN_HPP
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2022, Seyedmasoud Asadzadeh <seyedmasoud.asadzadeh@usi.ch>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PTPLIB_THREADS_TASKTRACER_HPP
+#define PTPLIB_THREADS_TASKTRACER_HPP
+
+#include "PTPLib/threads/InstanceLocal.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace PTPLib::threads {
+
+    // Records enqueue/start/end timestamps of pool tasks and dumps them as Chrome trace-event JSON
+    // (loadable in chrome://tracing or ui.perfetto.dev). Every recording thread appends to its own
+    // fixed-size buffer, so recording takes no lock; events beyond the capacity are counted as dropped.
+    class TaskTracer {
+    public:
+        typedef std::int64_t time_ns;
+
+        struct trace_event {
+            std::uint32_t name_id;
+            std::uint32_t category_id;
+            time_ns enqueued;
+            time_ns started;
+            time_ns ended;
+        };
+
+    private:
+        struct thread_buffer {
+            std::unique_ptr<trace_event[]> events;
+            std::atomic<std::size_t> size = 0;
+            std::atomic<std::size_t> dropped = 0;
+            std::unordered_map<std::string, std::uint32_t> name_cache;
+
+            explicit thread_buffer(std::size_t capacity) : events(new trace_event[capacity]) {}
+        };
+
+        const std::uint64_t tracer_id;
+        const std::size_t capacity;
+        const time_ns origin;
+
+        mutable std::mutex registry_mutex;
+        std::vector<std::unique_ptr<thread_buffer>> buffers;
+        std::vector<std::string> names;
+        std::unordered_map<std::string, std::uint32_t> name_ids;
+
+        thread_buffer & local_buffer() {
+            thread_local instance_local<thread_buffer> local_buffers;
+            if (thread_buffer * buffer = local_buffers.find(tracer_id))
+                return *buffer;
+            const std::scoped_lock lock(registry_mutex);
+            buffers.push_back(std::make_unique<thread_buffer>(capacity));
+            local_buffers.insert(tracer_id, buffers.back().get());
+            return *buffers.back();
+        }
+
+        std::uint32_t intern(thread_buffer & buffer, const std::string & name) {
+            auto it = buffer.name_cache.find(name);
+            if (it != buffer.name_cache.end())
+                return it->second;
+            const std::scoped_lock lock(registry_mutex);
+            auto inserted = name_ids.emplace(name, static_cast<std::uint32_t>(names.size()));
+            if (inserted.second)
+                names.push_back(name);
+            buffer.name_cache.emplace(name, inserted.first->second);
+            return inserted.first->second;
+        }
+
+        static void write_escaped(std::ostream & stream, const std::string & str) {
+            static const char hex[] = "0123456789abcdef";
+            for (char c : str) {
+                if (c == '"' || c == '\\')
+                    stream << '\\' << c;
+                else if ('\x00' <= c && c <= '\x1f')
+                    stream << "\\u00" << hex[(c >> 4) & 0xf] << hex[c & 0xf];
+                else
+                    stream << c;
+            }
+        }
+
+    public:
+        explicit TaskTracer(std::size_t _capacity_per_thread = 1 << 16)
+        : tracer_id(instance_ids::acquire())
+        , capacity(_capacity_per_thread)
+        , origin(now()) {}
+
+        ~TaskTracer() { instance_ids::release(tracer_id); }
+
+        TaskTracer(const TaskTracer &) = delete;
+
+        TaskTracer & operator=(const TaskTracer &) = delete;
+
+        static time_ns now() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        void record(const std::string & category, const std::string & name, time_ns enqueued, time_ns started, time_ns ended) {
+            thread_buffer & buffer = local_buffer();
+            std::size_t size = buffer.size.load(std::memory_order_relaxed);
+            if (size == capacity) {
+                buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            buffer.events[size] = trace_event{intern(buffer, name), intern(buffer, category), enqueued, started, ended};
+            buffer.size.store(size + 1, std::memory_order_release);
+        }
+
+        std::size_t get_dropped() const {
+            const std::scoped_lock lock(registry_mutex);
+            std::size_t dropped = 0;
+            for (auto & buffer : buffers)
+                dropped += buffer->dropped.load(std::memory_order_relaxed);
+            return dropped;
+        }
+
+        // Each task becomes a complete ("X") event on its worker's track and an async ("b"/"e") event spanning the
+        // time it spent queued. Safe to call while tasks are still being recorded.
+        void write_chrome_trace(std::ostream & stream) const {
+            const std::scoped_lock lock(registry_mutex);
+            auto to_us = [this](time_ns t) { return static_cast<double>(t - origin) / 1000.0; };
+            stream << "{\"traceEvents\":[";
+            bool first = true;
+            auto separator = [&first, &stream] {
+                if (not first)
+                    stream << ",\n";
+                first = false;
+            };
+            std::uint64_t queue_id = 0;
+            for (std::size_t tid = 0; tid < buffers.size(); ++tid) {
+                separator();
+                stream << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << tid
+                       << ",\"args\":{\"name\":\"worker " << tid << "\"}}";
+                const thread_buffer & buffer = *buffers[tid];
+                const std::size_t size = buffer.size.load(std::memory_order_acquire);
+                for (std::size_t i = 0; i < size; ++i) {
+                    const trace_event & event = buffer.events[i];
+                    separator();
+                    stream << "{\"ph\":\"X\",\"name\":\"";
+                    write_escaped(stream, names[event.name_id]);
+                    stream << "\",\"cat\":\"";
+                    write_escaped(stream, names[event.category_id]);
+                    stream << "\",\"pid\":1,\"tid\":" << tid << ",\"ts\":" << to_us(event.started)
+                           << ",\"dur\":" << static_cast<double>(event.ended - event.started) / 1000.0
+                           << ",\"args\":{\"queued_us\":"
+                           << (event.enqueued == 0 ? 0.0 : static_cast<double>(event.started - event.enqueued) / 1000.0) << "}}";
+                    if (event.enqueued == 0)
+                        continue;
+                    ++queue_id;
+                    for (auto phase : {"b", "e"}) {
+                        separator();
+                        stream << "{\"ph\":\"" << phase << "\",\"name\":\"";
+                        write_escaped(stream, names[event.name_id]);
+                        stream << "\",\"cat\":\"queue\",\"pid\":1,\"id\":" << queue_id << ",\"ts\":"
+                               << to_us(phase[0] == 'b' ? event.enqueued : event.started) << "}";
+                    }
+                }
+            }
+            stream << "]}\n";
+        }
+    };
+}
+
+#endif // PTPLIB_THREADS_TASKTRACER_HPP
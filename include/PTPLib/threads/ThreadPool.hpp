@@ -10,40 +10,125 @@
 #define PTPLIB_THREADS_THREADPOOl_HPP
 
 #include "PTPLib/common/Printer.hpp"
+#include "PTPLib/common/Exception.hpp"
+#include "PTPLib/threads/ProfiledMutex.hpp"
+#include "PTPLib/threads/StopToken.hpp"
+#include "PTPLib/threads/TaskTracer.hpp"
+#include "PTPLib/threads/TimerWheel.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <functional>
 #include <future>
 #include <iostream>
+#include <iterator>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <queue>
 #include <thread>
 #include <type_traits>
 #include <utility>
+#include <vector>
 #include <cassert>
 
 namespace PTPLib::threads {
 
+    // Handle of a task submitted together with a stop_token; request_stop() signals the running task through its
+    // token (running its stop callbacks right away) and drops the task if it has not started yet.
+    template<typename R>
+    class task_handle {
+        std::future<R> future;
+        stop_source source;
+
+    public:
+        task_handle() = default;
+
+        task_handle(std::future<R> && _future, stop_source _source) : future(std::move(_future)), source(std::move(_source)) {}
+
+        bool request_stop() { return source.request_stop(); }
+
+        stop_token get_token() const { return source.get_token(); }
+
+        bool valid() const { return future.valid(); }
+
+        void wait() const { future.wait(); }
+
+        R get() { return future.get(); }
+
+        std::future<R> & get_future() { return future; }
+    };
+
     class ThreadPool {
         typedef std::uint_fast32_t ui32;
 
         std::string pool_name;
 
-        mutable std::mutex queue_mutex = {};
+        mutable site_mutex<std::mutex> queue_mutex = make_site_mutex<std::mutex>("ThreadPool::queue_mutex");
 
         std::atomic<bool> running = true;
 
-        std::queue<std::pair<std::function<void()>, std::string>> tasks = {};
+        struct queued_task {
+            std::function<void()> task;
+            std::string name;
+            TaskTracer::time_ns enqueued = 0;
+        };
+
+        std::queue<queued_task> tasks = {};
 
         std::unique_ptr<std::vector<std::thread>> threads;
 
+        std::mutex threads_mutex = {};
+
+        std::vector<std::thread::id> retired_ids = {};
+
         std::atomic<ui32> tasks_total = 0;
 
+        std::atomic<ui32> live_threads = 0;
+
+        std::atomic<ui32> idle_threads = 0;
+
+        std::atomic<ui32> peak_threads = 0;
+
+        std::atomic<std::uint64_t> threads_spawned = 0;
+
+        std::atomic<std::uint64_t> threads_retired = 0;
+
+        std::atomic<bool> elastic = false;
+
+        std::atomic<ui32> min_threads = 0;
+
+        std::atomic<ui32> max_threads = 0;
+
+        std::atomic<std::int64_t> idle_timeout_ns = 0;
+
+        std::atomic<std::int64_t> spawn_latency_ns = 0;
+
         PTPLib::common::synced_stream * syncedStream = nullptr;
+
+        std::atomic<TaskTracer *> tracer = nullptr;
+
+        std::once_flag timer_wheel_once;
+
+        std::unique_ptr<TimerWheel> timer_wheel;
+
+        template<typename R>
+        struct batch_state;
     public:
+        struct pool_metrics {
+            ui32 threads;
+            ui32 idle_threads;
+            ui32 peak_threads;
+            std::uint64_t spawned;
+            std::uint64_t retired;
+        };
+
+        template<typename R>
+        using batch_result_t = std::conditional_t<std::is_void_v<R>, bool, std::vector<R>>;
+
         ThreadPool(std::string _pool_name = std::string(), const ui32 _thread_count = 0)
         : pool_name    (_pool_name) {
             threads = std::make_unique<std::vector<std::thread>>();
@@ -53,15 +138,53 @@ namespace PTPLib::threads {
         }
 
         ~ThreadPool() {
+            timer_wheel.reset();
             wait_for_tasks();
             running = false;
             destroy_threads();
             if (syncedStream)
-                syncedStream->println(PTPLib::common::Color::FG_BrightRed, pool_name, " destroyed!");
+                PTPLIB_LOG(*syncedStream, Info, THREAD_POOL, PTPLib::common::Color::FG_BrightRed, pool_name, " destroyed!");
         }
 
         void set_syncedStream(PTPLib::common::synced_stream & ss) { syncedStream = &ss; }
 
+        // Workers pick the tracer up with each task; clear it and wait for running tasks before destroying it.
+        void set_tracer(TaskTracer & tr) { tracer.store(&tr, std::memory_order_release); }
+
+        void clear_tracer() { tracer.store(nullptr, std::memory_order_release); }
+
+        // The wheel behind schedule_after() and schedule_every(), started on first use. Its callbacks run on the
+        // wheel's own thread, not on the pool.
+        TimerWheel & get_timer_wheel() {
+            std::call_once(timer_wheel_once, [this] { timer_wheel = std::make_unique<TimerWheel>(); });
+            return *timer_wheel;
+        }
+
+        // Pushes task to the pool once delay has elapsed, unless the handle or token cancels it first.
+        template<typename F>
+        timer_handle schedule_after(std::chrono::steady_clock::duration delay, const F & task,
+                                    std::string task_name = std::string(), const stop_token & token = stop_token()) {
+            return get_timer_wheel().schedule_after(delay, [this, body = std::function<void()>(task), task_name] {
+                push_task(body, task_name);
+            }, token);
+        }
+
+        // Pushes task to the pool every interval until the handle or token cancels it. An expiry is skipped while
+        // the previous run is still queued or running, so a slow task never piles up behind itself.
+        template<typename F>
+        timer_handle schedule_every(std::chrono::steady_clock::duration interval, const F & task,
+                                    std::string task_name = std::string(), const stop_token & token = stop_token()) {
+            auto busy = std::make_shared<std::atomic<bool>>(false);
+            return get_timer_wheel().schedule_every(interval, [this, busy, body = std::function<void()>(task), task_name] {
+                if (busy->exchange(true))
+                    return;
+                push_task([busy, body] {
+                    body();
+                    busy->store(false);
+                }, task_name);
+            }, token);
+        }
+
         size_t get_tasks_queued() const {
             const std::scoped_lock lock(queue_mutex);
             return tasks.size();
@@ -78,38 +201,131 @@ namespace PTPLib::threads {
         }
 
         std::size_t get_thread_count() const {
-            return threads->size();
+            return live_threads;
+        }
+
+        pool_metrics get_metrics() const {
+            return pool_metrics{live_threads, idle_threads, peak_threads, threads_spawned, threads_retired};
+        }
+
+        // Lets the pool keep between _min_threads and _max_threads workers: a worker is spawned when more tasks are
+        // queued than workers are idle, or when a popped task had waited longer than spawn_latency; a worker idle for
+        // longer than idle_timeout retires. Running tasks are never interrupted.
+        void set_elastic(ui32 _min_threads, ui32 _max_threads,
+                         std::chrono::milliseconds idle_timeout = std::chrono::seconds(1),
+                         std::chrono::microseconds spawn_latency = std::chrono::milliseconds(1)) {
+            assert(_min_threads <= _max_threads and _max_threads > 0);
+            min_threads = _min_threads;
+            max_threads = _max_threads;
+            idle_timeout_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(idle_timeout).count();
+            spawn_latency_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(spawn_latency).count();
+            elastic = true;
+            while (live_threads < _min_threads and spawn_worker()) {}
         }
 
+        void clear_elastic() { elastic = false; }
+
 
         template<typename T, typename F>
         void parallelize_loop(T first_index, T last_index, const F & loop, ui32 num_tasks = 0) {
-            if (num_tasks == 0)
-                num_tasks = get_thread_count();
             if (last_index < first_index)
                 std::swap(last_index, first_index);
-            size_t total_size = last_index - first_index + 1;
-            size_t block_size = total_size / num_tasks;
-            if (block_size == 0) {
-                block_size = 1;
-                num_tasks = (ui32) total_size > 1 ? (ui32) total_size : 1;
-            }
-            std::atomic<ui32> blocks_running = 0;
-            for (ui32 t = 0; t < num_tasks; t++) {
-                T start = (T) (t * block_size + first_index);
-                T end = (t == num_tasks - 1) ? last_index : (T) ((t + 1) * block_size + first_index - 1);
-                blocks_running++;
-                push_task([start, end, &loop, &blocks_running] {
-                    for (T i = start; i <= end; i++)
-                        loop(i);
-                    blocks_running--;
-                });
-            }
-            while (blocks_running != 0) {
-                sleep_or_yield();
+            // The count of [first_index, last_index], so that last_index may be the maximum of T.
+            const std::size_t total = index_distance(first_index, last_index) + 1;
+            std::size_t grain_size = 0;
+            if (num_tasks != 0)
+                grain_size = std::max<std::size_t>(1, total / num_tasks);
+            reduce_range(first_index, total, 0, [&loop](T i) {
+                loop(i);
+                return 0;
+            }, [](int, int) { return 0; }, grain_size);
+        }
+
+        // Runs loop(i) for every i in [first_index, end_index). The calling thread takes part in the work and blocks
+        // until every iteration finished. Idle participants claim chunks of the remaining range whose size shrinks as
+        // the range drains, but never below grain_size (0 picks 1), so skewed iterations still balance across threads.
+        template<typename T, typename F>
+        void parallel_for(T first_index, T end_index, const F & loop, std::size_t grain_size = 0) {
+            parallel_reduce(first_index, end_index, 0, [&loop](T i) {
+                loop(i);
+                return 0;
+            }, [](int, int) { return 0; }, grain_size);
+        }
+
+        // Folds combine(acc, loop(i)) over [first_index, end_index) with the same scheduling as parallel_for. Each
+        // participant folds its chunks locally starting from identity, so combine must be associative and commutative.
+        template<typename T, typename R, typename F, typename C>
+        R parallel_reduce(T first_index, T end_index, R identity, const F & loop, const C & combine, std::size_t grain_size = 0) {
+            if (not (first_index < end_index))
+                return identity;
+            return reduce_range(first_index, index_distance(first_index, end_index), std::move(identity), loop, combine, grain_size);
+        }
+
+    private:
+        // The number of indices from first to last, computed without overflowing T.
+        template<typename T>
+        static std::size_t index_distance(T first, T last) {
+            if constexpr (std::is_integral_v<T>)
+                return static_cast<std::size_t>(static_cast<std::make_unsigned_t<T>>(last) - static_cast<std::make_unsigned_t<T>>(first));
+            else
+                return static_cast<std::size_t>(last - first);
+        }
+
+        template<typename T>
+        static T index_at(T first, std::size_t i) {
+            if constexpr (std::is_integral_v<T>)
+                return static_cast<T>(static_cast<std::make_unsigned_t<T>>(first) + static_cast<std::make_unsigned_t<T>>(i));
+            else
+                return static_cast<T>(first + static_cast<T>(i));
+        }
+
+        // parallel_reduce over the total indices starting at first_index.
+        template<typename T, typename R, typename F, typename C>
+        R reduce_range(T first_index, std::size_t total, R identity, const F & loop, const C & combine, std::size_t grain_size) {
+            const std::size_t grain = std::max<std::size_t>(1, grain_size);
+            const std::size_t helpers = std::min<std::size_t>(get_thread_count(), (total + grain - 1) / grain - 1);
+            auto state = std::make_shared<loop_state<R>>(total, grain, helpers + 1, identity);
+
+            auto participate = [state, first_index, &loop, &combine] {
+                std::size_t begin, end, done = 0;
+                R partial = state->identity;
+                while (state->claim(begin, end)) {
+                    try {
+                        for (std::size_t i = begin; i < end; ++i)
+                            partial = combine(std::move(partial), loop(index_at(first_index, i)));
+                    }
+                    catch (...) {
+                        state->fail(std::current_exception());
+                    }
+                    done += end - begin;
+                }
+                if (done != 0) {
+                    // On a pool worker an exception must not escape; it reaches the caller like the loop's own.
+                    try {
+                        const std::scoped_lock lock(state->mutex);
+                        state->result = combine(std::move(state->result), std::move(partial));
+                    }
+                    catch (...) {
+                        state->fail(std::current_exception());
+                    }
+                    state->complete(done);
+                }
+            };
+            if (helpers != 0) {
+                std::vector<std::function<void()>> helper_tasks(helpers, participate);
+                push_tasks(helper_tasks.begin(), helper_tasks.end());
             }
+            participate();
+
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->cv.wait(lock, [&state] { return state->pending.load(std::memory_order_acquire) == 0; });
+            if (state->error)
+                std::rethrow_exception(state->error);
+            return std::move(state->result);
         }
 
+    public:
+
         template<typename F, typename R = std::invoke_result_t<std::decay_t<F>>>
         std::future<R> submit_task(const F & task, std::string task_name=std::string()) {
             std::shared_ptr<std::promise<R>> task_promise(new std::promise<R>);
@@ -134,20 +350,78 @@ namespace PTPLib::threads {
             tasks_total++;
             {
                 const std::scoped_lock lock(queue_mutex);
-                tasks.push(std::make_pair(std::function<void()>(task), task_name));
+                tasks.push(queued_task{std::function<void()>(task), task_name, enqueue_time()});
             }
+            grow_if_busy();
         }
 
+        // Enqueues every callable in [first, last) under a single acquisition of queue_mutex.
+        template<typename It>
+        void push_tasks(It first, It last, std::string task_name = std::string()) {
+            const auto count = static_cast<ui32>(std::distance(first, last));
+            if (count == 0)
+                return;
+            tasks_total += count;
+            {
+                const std::scoped_lock lock(queue_mutex);
+                const TaskTracer::time_ns enqueued = enqueue_time();
+                for (; first != last; ++first)
+                    tasks.push(queued_task{std::function<void()>(*first), task_name, enqueued});
+            }
+            grow_if_busy();
+        }
+
+        // Submits every callable in [first, last) as one batch. The returned future becomes ready once all of them
+        // finished; it holds the results in submission order (or true for void tasks) or the first exception thrown.
+        template<typename It, typename F = typename std::iterator_traits<It>::value_type,
+                typename R = std::invoke_result_t<std::decay_t<F>>>
+        std::future<batch_result_t<R>> submit_batch(It first, It last, std::string task_name = std::string()) {
+            const auto count = static_cast<std::size_t>(std::distance(first, last));
+            auto state = std::make_shared<batch_state<R>>(count);
+            std::future<batch_result_t<R>> future = state->promise.get_future();
+            if (count == 0) {
+                state->finish();
+                return future;
+            }
+            tasks_total += static_cast<ui32>(count);
+            {
+                const std::scoped_lock lock(queue_mutex);
+                const TaskTracer::time_ns enqueued = enqueue_time();
+                for (std::size_t i = 0; first != last; ++first, ++i) {
+                    tasks.push(queued_task{std::function<void()>([task = *first, state, i] {
+                        try {
+                            if constexpr (std::is_void_v<R>)
+                                task();
+                            else
+                                state->values[i].emplace(task());
+                        }
+                        catch (...) {
+                            if (not state->failed.test_and_set())
+                                state->error = std::current_exception();
+                        }
+                        if (state->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                            state->finish();
+                    }), task_name, enqueued});
+                }
+            }
+            grow_if_busy();
+            return future;
+        }
+
+        // Replaces the workers by _thread_count new ones; an elastic pool restarts with min_threads workers instead and
+        // keeps its bounds.
         void reset(const ui32 & _thread_count = std::thread::hardware_concurrency() - 1) {
             bool was_paused = paused;
             paused = true;
             wait_for_tasks();
             running = false;
             destroy_threads();
-            threads->clear();
             paused = was_paused;
-            create_threads(_thread_count);
             running = true;
+            if (elastic)
+                while (live_threads < min_threads and spawn_worker()) {}
+            else
+                create_threads(_thread_count);
         }
 
 
@@ -192,6 +466,36 @@ namespace PTPLib::threads {
             return future;
         }
 
+        // Submits a task that takes a stop_token as its only argument. If the stop is requested before the task is
+        // popped from the queue, it is dropped without running and its future holds an exception.
+        template<typename F, typename T = std::invoke_result_t<std::decay_t<F>, stop_token>,
+                typename R = std::conditional_t<std::is_void_v<T>, bool, T>>
+        task_handle<R> submit(const F & task, std::string task_name = std::string()) {
+            std::shared_ptr<std::promise<R>> task_promise(new std::promise<R>);
+            stop_source source;
+            task_handle<R> handle(task_promise->get_future(), source);
+            push_task([task, task_promise, token = source.get_token()] {
+                try {
+                    if (token.stop_requested())
+                        throw PTPLib::common::Exception(__FILE__, __LINE__, "task cancelled before it started");
+                    if constexpr (std::is_void_v<T>) {
+                        task(token);
+                        task_promise->set_value(true);
+                    }
+                    else
+                        task_promise->set_value(task(token));
+                }
+                catch (...) {
+                    try {
+                        task_promise->set_exception(std::current_exception());
+                    }
+                    catch (...) {
+                    }
+                }
+            }, task_name);
+            return handle;
+        }
+
         void wait_for_tasks()
         {
             while (true)
@@ -210,17 +514,26 @@ namespace PTPLib::threads {
             }
         }
 
+        // running must be false, so no worker is spawned once the threads are swapped out and all of them are joined.
         void destroy_threads() {
-            for (std::size_t i = 0; i < get_thread_count(); ++i) {
-                threads->at(i).join();
+            assert(not running);
+            std::vector<std::thread> joining;
+            {
+                const std::scoped_lock lock(threads_mutex);
+                std::swap(joining, *threads);
             }
+            for (auto & thread : joining) {
+                thread.join();
+            }
+            const std::scoped_lock lock(threads_mutex);
+            retired_ids.clear();
+            live_threads = 0;
+            idle_threads = 0;
         }
 
         void increase(ui32 tc) {
             assert(get_thread_count() < std::thread::hardware_concurrency());
-            for (ui32 i = 0; i < tc; ++i) {
-                threads->push_back(std::thread(&ThreadPool::worker, this));
-            }
+            add_threads(tc);
         }
 
         std::atomic<bool> paused = false;
@@ -228,14 +541,173 @@ namespace PTPLib::threads {
         ui32 sleep_duration = 1000;
 
     private:
+        template<typename R>
+        struct loop_state {
+            std::atomic<std::size_t> next = 0;
+            std::atomic<std::size_t> pending;
+            const std::size_t total;
+            const std::size_t grain;
+            const std::size_t participants;
+            std::mutex mutex;
+            std::condition_variable cv;
+            const R identity;
+            R result;
+            std::atomic_flag failed = ATOMIC_FLAG_INIT;
+            std::exception_ptr error;
+
+            loop_state(std::size_t _total, std::size_t _grain, std::size_t _participants, const R & _identity)
+            : pending(_total), total(_total), grain(_grain), participants(_participants), identity(_identity), result(_identity) {}
+
+            bool claim(std::size_t & begin, std::size_t & end) {
+                std::size_t current = next.load(std::memory_order_relaxed);
+                while (current < total) {
+                    std::size_t chunk = std::max(grain, (total - current) / (2 * participants));
+                    std::size_t stop = std::min(total, current + chunk);
+                    if (next.compare_exchange_weak(current, stop, std::memory_order_relaxed)) {
+                        begin = current;
+                        end = stop;
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            void complete(std::size_t count) {
+                if (pending.fetch_sub(count, std::memory_order_acq_rel) == count) {
+                    const std::scoped_lock lock(mutex);
+                    cv.notify_all();
+                }
+            }
+
+            void fail(std::exception_ptr exception) {
+                if (not failed.test_and_set()) {
+                    const std::scoped_lock lock(mutex);
+                    error = exception;
+                }
+                std::size_t unclaimed = next.exchange(total, std::memory_order_relaxed);
+                if (unclaimed < total)
+                    complete(total - unclaimed);
+            }
+        };
+
+        template<typename R>
+        struct batch_state {
+            std::promise<batch_result_t<R>> promise;
+            std::atomic<std::size_t> remaining;
+            std::vector<std::optional<std::conditional_t<std::is_void_v<R>, bool, R>>> values;
+            std::atomic_flag failed = ATOMIC_FLAG_INIT;
+            std::exception_ptr error;
+
+            explicit batch_state(std::size_t count) : remaining(count) {
+                if constexpr (not std::is_void_v<R>)
+                    values.resize(count);
+            }
+
+            void finish() {
+                if (error) {
+                    promise.set_exception(error);
+                    return;
+                }
+                if constexpr (std::is_void_v<R>)
+                    promise.set_value(true);
+                else {
+                    std::vector<R> results;
+                    results.reserve(values.size());
+                    for (auto & value : values)
+                        results.push_back(std::move(*value));
+                    promise.set_value(std::move(results));
+                }
+            }
+        };
+
         void create_threads(const ui32 _thread_count) {
             assert(_thread_count < std::thread::hardware_concurrency());
+            add_threads(_thread_count);
+        }
+
+        void add_threads(const ui32 _thread_count) {
+            const std::scoped_lock lock(threads_mutex);
             for (ui32 i = 0; i < _thread_count; ++i) {
+                ++live_threads;
+                ++idle_threads;
                 threads->push_back(std::thread(&ThreadPool::worker, this));
             }
+            update_peak();
+        }
+
+        void update_peak() {
+            ui32 live = live_threads;
+            ui32 peak = peak_threads;
+            while (live > peak and not peak_threads.compare_exchange_weak(peak, live)) {}
         }
 
-        bool pop_task(std::pair<std::function<void()>, std::string> & task) {
+        // Joins workers that retired since the last call; threads_mutex must be held.
+        void reap_retired() {
+            if (retired_ids.empty())
+                return;
+            auto retired = [this](std::thread & thread) {
+                return std::find(retired_ids.begin(), retired_ids.end(), thread.get_id()) != retired_ids.end();
+            };
+            for (auto & thread : *threads) {
+                if (retired(thread))
+                    thread.join();
+            }
+            threads->erase(std::remove_if(threads->begin(), threads->end(), [](std::thread & thread) {
+                return not thread.joinable();
+            }), threads->end());
+            retired_ids.clear();
+        }
+
+        // Checks running under threads_mutex, so a stopping pool spawns nothing destroy_threads() would miss.
+        bool spawn_worker() {
+            {
+                const std::scoped_lock lock(threads_mutex);
+                if (not running)
+                    return false;
+                ui32 live = live_threads;
+                do {
+                    if (live >= max_threads)
+                        return false;
+                } while (not live_threads.compare_exchange_weak(live, live + 1));
+                ++idle_threads;
+                reap_retired();
+                threads->push_back(std::thread(&ThreadPool::worker, this));
+            }
+            ++threads_spawned;
+            update_peak();
+            if (syncedStream)
+                PTPLIB_LOG(*syncedStream, Info, THREAD_POOL, PTPLib::common::Color::FG_Yellow, "THREAD_POOL -> WORKER SPAWNED, THREADS: ", live_threads);
+            return true;
+        }
+
+        bool try_retire() {
+            ui32 live = live_threads;
+            do {
+                if (live <= min_threads)
+                    return false;
+            } while (not live_threads.compare_exchange_weak(live, live - 1));
+            {
+                const std::scoped_lock lock(threads_mutex);
+                retired_ids.push_back(std::this_thread::get_id());
+            }
+            ++threads_retired;
+            if (syncedStream)
+                PTPLIB_LOG(*syncedStream, Info, THREAD_POOL, PTPLib::common::Color::FG_Yellow, "THREAD_POOL -> WORKER RETIRED, THREADS: ", live_threads);
+            return true;
+        }
+
+        void grow_if_busy() {
+            if (not elastic)
+                return;
+            std::size_t queued = get_tasks_queued();
+            while (queued > idle_threads and spawn_worker()) {}
+        }
+
+        TaskTracer::time_ns enqueue_time() const {
+            return (tracer.load(std::memory_order_acquire) or elastic) ? TaskTracer::now() : 0;
+        }
+
+        bool pop_task(queued_task & task) {
             const std::scoped_lock lock(queue_mutex);
             if (tasks.empty())
                 return false;
@@ -254,19 +726,44 @@ namespace PTPLib::threads {
         }
 
         void worker() {
+            bool idle = true;
+            TaskTracer::time_ns idle_since = TaskTracer::now();
             while (running) {
-                std::pair<std::function<void()>, std::string> task;
+                queued_task task;
                 if (!paused && pop_task(task)) {
+                    if (idle) {
+                        idle = false;
+                        --idle_threads;
+                    }
+                    if (elastic and task.enqueued != 0 and TaskTracer::now() - task.enqueued > spawn_latency_ns
+                        and get_tasks_queued() != 0)
+                        spawn_worker();
                     if (syncedStream)
-                        syncedStream->println(PTPLib::common::Color::FG_Yellow, "THREAD_POOL -> TASK STARTED : ", task.second);
+                        PTPLIB_LOG(*syncedStream, Debug, THREAD_POOL, PTPLib::common::Color::FG_Yellow, "THREAD_POOL -> TASK STARTED : ", task.name);
 
-                    task.first();
+                    TaskTracer * const task_tracer = tracer.load(std::memory_order_acquire);
+                    if (task_tracer) {
+                        const TaskTracer::time_ns started = TaskTracer::now();
+                        task.task();
+                        task_tracer->record(pool_name, task.name, task.enqueued, started, TaskTracer::now());
+                    }
+                    else
+                        task.task();
                     tasks_total--;
 
                     if (syncedStream)
-                        syncedStream->println(PTPLib::common::Color::FG_Yellow, "THREAD_POOL -> TASK ENDED : ", task.second, " REMAINED TASKS: ", tasks_total);
+                        PTPLIB_LOG(*syncedStream, Debug, THREAD_POOL, PTPLib::common::Color::FG_Yellow, "THREAD_POOL -> TASK ENDED : ", task.name, " REMAINED TASKS: ", tasks_total);
                 }
                 else {
+                    if (not idle) {
+                        idle = true;
+                        ++idle_threads;
+                        idle_since = TaskTracer::now();
+                    }
+                    else if (elastic and TaskTracer::now() - idle_since > idle_timeout_ns and try_retire()) {
+                        --idle_threads;
+                        return;
+                    }
                     sleep_or_yield();
                 }
             }
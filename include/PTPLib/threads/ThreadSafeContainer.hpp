@@ -2,11 +2,78 @@
 #ifndef PTPLIB_THREADS_SAFE_PTR_HPP
 #define PTPLIB_THREADS_SAFE_PTR_HPP
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <thread>
+#include <utility>
+#include <vector>
 
 namespace PTPLib::threads {
 
+    struct lock_stats {
+        std::uint64_t acquisitions;
+        std::uint64_t contended;
+    };
+
+    // Wraps a mutex and counts acquisitions and the ones that had to wait because try_lock failed first.
+    // The shared members only compile when mutex_t itself is a shared mutex.
+    template<typename mutex_t>
+    class contention_counting_mutex {
+        mutex_t mtx;
+        std::atomic<std::uint64_t> acquisitions = 0;
+        std::atomic<std::uint64_t> contended = 0;
+
+    public:
+        void lock() {
+            if (not mtx.try_lock()) {
+                contended.fetch_add(1, std::memory_order_relaxed);
+                mtx.lock();
+            }
+            acquisitions.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        bool try_lock() {
+            if (not mtx.try_lock())
+                return false;
+            acquisitions.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        void unlock() { mtx.unlock(); }
+
+        void lock_shared() {
+            if (not mtx.try_lock_shared()) {
+                contended.fetch_add(1, std::memory_order_relaxed);
+                mtx.lock_shared();
+            }
+            acquisitions.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        bool try_lock_shared() {
+            if (not mtx.try_lock_shared())
+                return false;
+            acquisitions.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        void unlock_shared() { mtx.unlock_shared(); }
+
+        lock_stats get_stats() const {
+            return lock_stats{acquisitions.load(std::memory_order_relaxed), contended.load(std::memory_order_relaxed)};
+        }
+
+        void reset_stats() {
+            acquisitions.store(0, std::memory_order_relaxed);
+            contended.store(0, std::memory_order_relaxed);
+        }
+    };
+
     template<typename T, typename mutex_t = std::recursive_mutex, typename x_lock_t = std::unique_lock<mutex_t>,
             typename s_lock_t = std::unique_lock<mutex_t >>
     class safe_ptr {
@@ -50,6 +117,9 @@ namespace PTPLib::threads {
         template<size_t, typename, size_t, size_t> friend
         class lock_timed_any;
 
+        template<size_t> friend
+        class ordered_lock;
+
         template<class mutex_type> friend
         class std::lock_guard;
 
@@ -64,8 +134,18 @@ namespace PTPLib::threads {
         const auto_lock_t<s_lock_t> operator->() const { return auto_lock_t<s_lock_t>(ptr.get(), *mtx_ptr); }
 
         const auto_lock_obj_t<s_lock_t> operator*() const { return auto_lock_obj_t<s_lock_t>(ptr.get(), *mtx_ptr); }
+
+        mutex_t & get_mutex() const { return *mtx_ptr; }
     };
 
+    // Read-mostly state: the const accessors take a shared lock, so readers proceed in parallel.
+    template<typename T, typename mutex_t = std::shared_mutex>
+    using shared_safe_ptr = safe_ptr<T, mutex_t, std::unique_lock<mutex_t>, std::shared_lock<mutex_t>>;
+
+    // A shared_safe_ptr whose get_mutex().get_stats() reports acquisitions and contended waits.
+    template<typename T>
+    using counted_shared_safe_ptr = shared_safe_ptr<T, contention_counting_mutex<std::shared_mutex>>;
+
     struct link_safe_ptrs {
         template<typename T1, typename... Args>
         link_safe_ptrs(T1 & first_ptr, Args & ... args) {
@@ -82,6 +162,7 @@ namespace PTPLib::threads {
         lock_once, lock_infinity
     };
 
+    // Spins, sleeps and retries; ordered_lock below locks the same safe_ptrs without sleeps or allocations.
     template<size_t lock_count, typename duration = std::chrono::nanoseconds,
             size_t deadlock_timeout = 100000, size_t spin_iterations = 100>
 
@@ -139,6 +220,102 @@ namespace PTPLib::threads {
 
     using lock_timed_any_once = lock_timed_any<lock_count_t::lock_once>;
     using lock_timed_any_infinity = lock_timed_any<lock_count_t::lock_infinity>;
+
+    // Locks the mutexes of several safe_ptrs in address order, so two ordered_locks over the same safe_ptrs never
+    // deadlock whatever the argument order; safe_ptrs sharing a mutex (see link_safe_ptrs) lock it once.
+    // Holds no heap memory and never sleeps: blocking waits are left to the mutexes themselves.
+    // With std::try_to_lock nothing blocks, and if any mutex is busy every acquired one is released again.
+    template<size_t N>
+    class ordered_lock {
+        struct entry {
+            void * mtx;
+            void (* lock)(void *);
+            bool (* try_lock)(void *);
+            void (* unlock)(void *);
+        };
+
+        std::array<entry, N> entries;
+        size_t locked_count = 0;
+
+        template<typename mutex_t>
+        static entry make_entry(mutex_t & mtx) {
+            return entry{&mtx,
+                         [](void * m) { static_cast<mutex_t *>(m)->lock(); },
+                         [](void * m) { return static_cast<mutex_t *>(m)->try_lock(); },
+                         [](void * m) { static_cast<mutex_t *>(m)->unlock(); }};
+        }
+
+        // Sorts by address and moves duplicates to the back; returns the number of distinct mutexes.
+        size_t order() {
+            for (size_t i = 1; i < N; ++i) {
+                for (size_t j = i; j > 0 and std::less<void *>()(entries[j].mtx, entries[j - 1].mtx); --j)
+                    std::swap(entries[j], entries[j - 1]);
+            }
+            size_t distinct = 0;
+            for (size_t i = 0; i < N; ++i) {
+                if (distinct == 0 or entries[i].mtx != entries[distinct - 1].mtx)
+                    entries[distinct++] = entries[i];
+            }
+            return distinct;
+        }
+
+        void release() {
+            while (locked_count != 0) {
+                --locked_count;
+                entries[locked_count].unlock(entries[locked_count].mtx);
+            }
+        }
+
+    public:
+        template<typename... Args>
+        explicit ordered_lock(Args & ... args) : entries{make_entry(*args.mtx_ptr) ...} {
+            static_assert(sizeof...(Args) == N, "ordered_lock<N> takes N safe_ptrs");
+            const size_t distinct = order();
+            // A throwing lock() leaves no destructor to run, so the mutexes already taken are released here.
+            try {
+                for (; locked_count < distinct; ++locked_count)
+                    entries[locked_count].lock(entries[locked_count].mtx);
+            } catch (...) {
+                release();
+                throw;
+            }
+        }
+
+        template<typename... Args>
+        ordered_lock(std::try_to_lock_t, Args & ... args) : entries{make_entry(*args.mtx_ptr) ...} {
+            static_assert(sizeof...(Args) == N, "ordered_lock<N> takes N safe_ptrs");
+            const size_t distinct = order();
+            try {
+                for (; locked_count < distinct; ++locked_count) {
+                    if (not entries[locked_count].try_lock(entries[locked_count].mtx)) {
+                        release();
+                        return;
+                    }
+                }
+            } catch (...) {
+                release();
+                throw;
+            }
+        }
+
+        ~ordered_lock() { release(); }
+
+        explicit operator bool() const noexcept { return locked_count != 0; }
+
+        ordered_lock(ordered_lock && other) noexcept
+        : entries(other.entries)
+        , locked_count(std::exchange(other.locked_count, 0)) {}
+
+        ordered_lock(const ordered_lock &) = delete;
+
+        ordered_lock & operator=(const ordered_lock &) = delete;
+    };
+
+    template<typename... Args>
+    ordered_lock(Args & ...) -> ordered_lock<sizeof...(Args)>;
+
+    template<typename... Args>
+    ordered_lock(std::try_to_lock_t, Args & ...) -> ordered_lock<sizeof...(Args)>;
 }
 
 #endif // PTPLIB_THREADS_SAFE_PTR_HPP
\ No newline at end of file
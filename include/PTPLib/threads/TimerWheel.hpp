@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2022, Seyedmasoud Asadzadeh <seyedmasoud.asadzadeh@usi.ch>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PTPLIB_THREADS_TIMERWHEEL_HPP
+#define PTPLIB_THREADS_TIMERWHEEL_HPP
+
+#include "PTPLib/threads/StopToken.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace PTPLib::threads {
+
+    class timer_handle;
+
+    // A hierarchical timer wheel (4 levels of 64 slots) driven by one thread. Callbacks run on that thread and
+    // should only hand work off, e.g. push it to a ThreadPool. The thread sleeps until the next occupied slot of
+    // the lowest level or the next cascade, so far-away timers cost a few wakeups per second at most.
+    class TimerWheel {
+    public:
+        typedef std::chrono::steady_clock clock;
+
+    private:
+        static constexpr unsigned slot_bits = 6;
+        static constexpr std::uint64_t slot_count = 1u << slot_bits;
+        static constexpr std::uint64_t slot_mask = slot_count - 1;
+        static constexpr unsigned levels = 4;
+        static constexpr std::uint64_t max_delta = (std::uint64_t(1) << (slot_bits * levels)) - 1;
+
+        struct timer_entry {
+            TimerWheel * wheel = nullptr;
+            std::uint64_t deadline = 0;
+            std::uint64_t period = 0;
+            std::function<void()> callback;
+            std::atomic<bool> cancelled = false;
+            std::unique_ptr<stop_callback> on_stop;
+        };
+
+        typedef std::shared_ptr<timer_entry> entry_ptr;
+
+        friend class timer_handle;
+
+        const clock::duration tick;
+        const clock::time_point origin;
+        std::uint64_t current_tick = 0;
+        std::size_t pending = 0;
+        std::array<std::array<std::vector<entry_ptr>, slot_count>, levels> slots;
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::condition_variable idle_cv;
+        const timer_entry * running_entry = nullptr;
+        bool running = true;
+        std::thread thread;
+
+        std::uint64_t ticks_until(clock::duration delay) const {
+            auto ticks = (delay + tick - clock::duration(1)) / tick;
+            return ticks <= 0 ? 0 : static_cast<std::uint64_t>(ticks);
+        }
+
+        // A deadline already passed takes the next tick's slot but keeps its value, so a late periodic timer's
+        // next deadline is still a whole number of periods from its first.
+        void insert(entry_ptr entry) {
+            const std::uint64_t deadline = std::max(entry->deadline, current_tick + 1);
+            const std::uint64_t delta = std::min(deadline - current_tick, max_delta);
+            unsigned level = 0;
+            while (level + 1 < levels and delta >= (std::uint64_t(1) << (slot_bits * (level + 1))))
+                ++level;
+            const std::uint64_t target = level == 0 ? deadline : current_tick + delta;
+            slots[level][(target >> (slot_bits * level)) & slot_mask].push_back(std::move(entry));
+        }
+
+        // Advances one tick and moves the due and the cancelled entries into due; mutex must be held.
+        void advance(std::vector<entry_ptr> & due) {
+            ++current_tick;
+            unsigned top = 0;
+            while (top + 1 < levels and ((current_tick >> (slot_bits * (top + 1))) << (slot_bits * (top + 1))) == current_tick)
+                ++top;
+            for (unsigned level = top; level > 0; --level) {
+                auto cascading = std::move(slots[level][(current_tick >> (slot_bits * level)) & slot_mask]);
+                slots[level][(current_tick >> (slot_bits * level)) & slot_mask].clear();
+                // An entry due on the tick of its cascade fires now rather than one tick later.
+                for (auto & entry : cascading) {
+                    if (entry->deadline <= current_tick or entry->cancelled)
+                        due.push_back(std::move(entry));
+                    else
+                        insert(std::move(entry));
+                }
+            }
+            auto expiring = std::move(slots[0][current_tick & slot_mask]);
+            slots[0][current_tick & slot_mask].clear();
+            for (auto & entry : expiring) {
+                if (entry->deadline > current_tick and not entry->cancelled)
+                    insert(std::move(entry));
+                else
+                    due.push_back(std::move(entry));
+            }
+        }
+
+        // Ticks left until the next occupied lowest-level slot or the next cascade; mutex must be held.
+        std::uint64_t idle_ticks() const {
+            const std::uint64_t to_cascade = slot_count - (current_tick & slot_mask);
+            for (std::uint64_t i = 1; i < to_cascade; ++i) {
+                if (not slots[0][(current_tick + i) & slot_mask].empty())
+                    return i;
+            }
+            return to_cascade;
+        }
+
+        std::uint64_t now_tick() const { return static_cast<std::uint64_t>((clock::now() - origin) / tick); }
+
+        void run() {
+            std::unique_lock<std::mutex> lock(mutex);
+            std::vector<entry_ptr> due;
+            while (running) {
+                // add() moves current_tick to the present while nothing is pending, so a timer added during the wait
+                // keeps its slot ahead of current_tick.
+                if (pending == 0) {
+                    cv.wait(lock);
+                    continue;
+                }
+                const std::uint64_t wake = current_tick + idle_ticks();
+                if (now_tick() < wake) {
+                    cv.wait_until(lock, origin + tick * static_cast<clock::rep>(wake));
+                    if (now_tick() < wake)
+                        continue;
+                }
+                const std::uint64_t target = now_tick();
+                while (current_tick < target)
+                    advance(due);
+                if (due.empty())
+                    continue;
+                for (auto & entry : due) {
+                    if (entry->cancelled)
+                        continue;
+                    running_entry = entry.get();
+                    lock.unlock();
+                    entry->callback();
+                    lock.lock();
+                    running_entry = nullptr;
+                    idle_cv.notify_all();
+                }
+                for (auto & entry : due) {
+                    if (entry->period != 0 and not entry->cancelled) {
+                        entry->deadline += entry->period;
+                        insert(std::move(entry));
+                    }
+                    else
+                        --pending;
+                }
+                // Dropping an entry deregisters its stop callback, which may be cancelling it and need the mutex.
+                lock.unlock();
+                due.clear();
+                lock.lock();
+            }
+        }
+
+        // Once this returns the callback of entry is neither running nor started again, unless called from the callback.
+        void cancel(timer_entry & entry) {
+            entry.cancelled = true;
+            if (std::this_thread::get_id() == thread.get_id())
+                return;
+            std::unique_lock<std::mutex> lock(mutex);
+            idle_cv.wait(lock, [this, &entry] { return running_entry != &entry; });
+        }
+
+        timer_handle add(clock::duration delay, clock::duration period, std::function<void()> callback, const stop_token & token);
+
+    public:
+        explicit TimerWheel(clock::duration _tick = std::chrono::milliseconds(1))
+        : tick(_tick)
+        , origin(clock::now())
+        , thread(&TimerWheel::run, this) {}
+
+        ~TimerWheel() {
+            {
+                const std::scoped_lock lock(mutex);
+                running = false;
+            }
+            cv.notify_all();
+            thread.join();
+            for (auto & level : slots) {
+                for (auto & slot : level)
+                    slot.clear();
+            }
+        }
+
+        TimerWheel(const TimerWheel &) = delete;
+
+        TimerWheel & operator=(const TimerWheel &) = delete;
+
+        // Runs callback once after delay, unless the handle or token cancels it first.
+        timer_handle schedule_after(clock::duration delay, std::function<void()> callback, const stop_token & token = stop_token());
+
+        // Runs callback every interval, starting one interval from now, until the handle or token cancels it.
+        timer_handle schedule_every(clock::duration interval, std::function<void()> callback, const stop_token & token = stop_token());
+
+        // Timers not dropped yet; a cancelled timer is only dropped when it would have expired.
+        std::size_t size() {
+            const std::scoped_lock lock(mutex);
+            return pending;
+        }
+    };
+
+    class timer_handle {
+        std::weak_ptr<TimerWheel::timer_entry> entry;
+
+        friend class TimerWheel;
+
+        explicit timer_handle(std::weak_ptr<TimerWheel::timer_entry> _entry) : entry(std::move(_entry)) {}
+
+    public:
+        timer_handle() = default;
+
+        // Waits for a run of the callback in progress, so do not call it while holding a lock the callback takes.
+        void cancel() {
+            if (auto locked = entry.lock())
+                locked->wheel->cancel(*locked);
+        }
+
+        bool active() const {
+            auto locked = entry.lock();
+            return locked and not locked->cancelled;
+        }
+    };
+
+    inline timer_handle TimerWheel::add(clock::duration delay, clock::duration period, std::function<void()> callback,
+                                        const stop_token & token) {
+        auto entry = std::make_shared<timer_entry>();
+        entry->wheel = this;
+        entry->period = ticks_until(period);
+        entry->callback = std::move(callback);
+        std::weak_ptr<timer_entry> weak = entry;
+        if (token.stop_possible()) {
+            entry->on_stop = std::make_unique<stop_callback>(token, [weak] {
+                if (auto locked = weak.lock())
+                    locked->wheel->cancel(*locked);
+            });
+        }
+        {
+            const std::scoped_lock lock(mutex);
+            const std::uint64_t now = now_tick();
+            if (pending == 0)
+                current_tick = std::max(current_tick, now);
+            // now is the tick already begun, so the first tick not earlier than delay from here is one later.
+            entry->deadline = std::max(current_tick, now) + 1 + ticks_until(delay);
+            ++pending;
+            insert(std::move(entry));
+        }
+        cv.notify_all();
+        return timer_handle(std::move(weak));
+    }
+
+    inline timer_handle TimerWheel::schedule_after(clock::duration delay, std::function<void()> callback, const stop_token & token) {
+        return add(delay, clock::duration(0), std::move(callback), token);
+    }
+
+    inline timer_handle TimerWheel::schedule_every(clock::duration interval, std::function<void()> callback, const stop_token & token) {
+        return add(interval, std::max(interval, tick), std::move(callback), token);
+    }
+}
+
+#endif // PTPLIB_THREADS_TIMERWHEEL_HPP
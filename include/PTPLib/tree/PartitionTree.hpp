@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2022, Seyedmasoud Asadzadeh <seyedmasoud.asadzadeh@usi.ch>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PTPLIB_TREE_PARTITIONTREE_HPP
+#define PTPLIB_TREE_PARTITIONTREE_HPP
+
+#include "PTPLib/common/Exception.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+namespace PTPLib::tree {
+
+    enum class node_status : std::uint8_t { UNKNOWN, SAT, UNSAT };
+
+    // A partition tree in flat arrays indexed by node id, without an allocation per node. The root is node 0 and the
+    // children of a node get consecutive ids when it is partitioned. Results propagate as in the protocol: a node is
+    // satisfiable iff one of its children is, so SAT goes up to the root, UNSAT goes up once every sibling is UNSAT,
+    // both in O(depth), and the descendants of an UNSAT node become UNSAT. The frontier, the leaves still to solve, is
+    // a linked list through the nodes.
+    class PartitionTree {
+    public:
+        typedef std::uint32_t node_id;
+
+        static constexpr node_id no_node = std::numeric_limits<node_id>::max();
+
+    private:
+        std::vector<node_id> parents;
+        std::vector<node_id> first_children;
+        std::vector<std::uint32_t> child_counts;
+        // Children that are not UNSAT yet; the node is UNSAT when it drops to zero.
+        std::vector<std::uint32_t> open_children;
+        std::vector<std::uint32_t> depths;
+        std::vector<node_status> statuses;
+
+        std::vector<node_id> frontier_next;
+        std::vector<node_id> frontier_prev;
+        node_id frontier_head = no_node;
+        std::size_t frontier_count = 0;
+
+        std::vector<node_id> pending;
+
+        node_id add_node(node_id parent, std::uint32_t depth) {
+            const node_id id = static_cast<node_id>(parents.size());
+            parents.push_back(parent);
+            first_children.push_back(no_node);
+            child_counts.push_back(0);
+            open_children.push_back(0);
+            depths.push_back(depth);
+            statuses.push_back(node_status::UNKNOWN);
+            frontier_next.push_back(no_node);
+            frontier_prev.push_back(no_node);
+            return id;
+        }
+
+        void check(node_id node) const {
+            if (node >= parents.size())
+                throw PTPLib::common::Exception(__FILE__, __LINE__, "PartitionTree: no node " + std::to_string(node));
+        }
+
+        void link_after(node_id prev, node_id node) {
+            frontier_prev[node] = prev;
+            frontier_next[node] = prev == no_node ? frontier_head : frontier_next[prev];
+            if (frontier_next[node] != no_node)
+                frontier_prev[frontier_next[node]] = node;
+            (prev == no_node ? frontier_head : frontier_next[prev]) = node;
+            ++frontier_count;
+        }
+
+        void unlink(node_id node) {
+            if (frontier_prev[node] == no_node)
+                frontier_head = frontier_next[node];
+            else
+                frontier_next[frontier_prev[node]] = frontier_next[node];
+            if (frontier_next[node] != no_node)
+                frontier_prev[frontier_next[node]] = frontier_prev[node];
+            frontier_next[node] = frontier_prev[node] = no_node;
+            --frontier_count;
+        }
+
+        // Marks the UNKNOWN nodes below node UNSAT and takes their leaves off the frontier.
+        void close_subtree(node_id node) {
+            pending.assign(1, node);
+            while (not pending.empty()) {
+                const node_id current = pending.back();
+                pending.pop_back();
+                for (node_id child = first_children[current]; child != no_node and child < first_children[current] + child_counts[current]; ++child) {
+                    if (statuses[child] != node_status::UNKNOWN)
+                        continue;
+                    statuses[child] = node_status::UNSAT;
+                    if (is_in_frontier(child))
+                        unlink(child);
+                    pending.push_back(child);
+                }
+                open_children[current] = 0;
+            }
+        }
+
+    public:
+        explicit PartitionTree(std::size_t expected_nodes = 0) {
+            reserve(expected_nodes);
+            add_node(no_node, 0);
+            link_after(no_node, root());
+        }
+
+        void reserve(std::size_t nodes) {
+            parents.reserve(nodes);
+            first_children.reserve(nodes);
+            child_counts.reserve(nodes);
+            open_children.reserve(nodes);
+            depths.reserve(nodes);
+            statuses.reserve(nodes);
+            frontier_next.reserve(nodes);
+            frontier_prev.reserve(nodes);
+        }
+
+        node_id root() const { return 0; }
+
+        std::size_t size() const { return parents.size(); }
+
+        // Splits an open leaf into children nodes that take its place on the frontier; returns the first child's id.
+        node_id partition(node_id node, std::uint32_t children) {
+            check(node);
+            if (children == 0)
+                throw PTPLib::common::Exception(__FILE__, __LINE__, "PartitionTree: partition into no children");
+            if (not is_in_frontier(node))
+                throw PTPLib::common::Exception(__FILE__, __LINE__, "PartitionTree: node " + std::to_string(node) + " is not an open leaf");
+            if (parents.size() + children >= no_node)
+                throw PTPLib::common::Exception(__FILE__, __LINE__, "PartitionTree: too many nodes");
+            const node_id first = static_cast<node_id>(parents.size());
+            first_children[node] = first;
+            child_counts[node] = children;
+            open_children[node] = children;
+            node_id prev = node;
+            for (std::uint32_t i = 0; i < children; ++i) {
+                const node_id child = add_node(node, depths[node] + 1);
+                link_after(prev, child);
+                prev = child;
+            }
+            unlink(node);
+            return first;
+        }
+
+        // Records a solver's result for node and propagates it; a result contradicting a known one throws.
+        void set_status(node_id node, node_status status) {
+            check(node);
+            if (status == node_status::UNKNOWN or status == statuses[node])
+                return;
+            if (statuses[node] != node_status::UNKNOWN)
+                throw PTPLib::common::Exception(__FILE__, __LINE__, "PartitionTree: conflicting result for node " + std::to_string(node));
+            if (status == node_status::SAT) {
+                for (node_id current = node; current != no_node and statuses[current] != node_status::SAT; current = parents[current])
+                    statuses[current] = node_status::SAT;
+                // The root is solved, nothing is left to open.
+                while (frontier_head != no_node)
+                    unlink(frontier_head);
+                return;
+            }
+            // Find the highest node that becomes UNSAT before changing anything, so a conflict leaves the tree as it was.
+            node_id top = node;
+            while (parents[top] != no_node and open_children[parents[top]] == 1) {
+                if (statuses[parents[top]] == node_status::SAT)
+                    throw PTPLib::common::Exception(__FILE__, __LINE__, "PartitionTree: node " + std::to_string(parents[top])
+                                                                        + " is SAT but all its children are UNSAT");
+                top = parents[top];
+            }
+            for (node_id current = node;; current = parents[current]) {
+                statuses[current] = node_status::UNSAT;
+                if (is_in_frontier(current))
+                    unlink(current);
+                close_subtree(current);
+                if (current == top)
+                    break;
+            }
+            if (parents[top] != no_node)
+                --open_children[parents[top]];
+        }
+
+        node_status status(node_id node) const { return statuses[node]; }
+
+        node_status root_status() const { return statuses[root()]; }
+
+        node_id parent(node_id node) const { return parents[node]; }
+
+        std::uint32_t child_count(node_id node) const { return child_counts[node]; }
+
+        node_id child(node_id node, std::uint32_t index) const {
+            return index < child_counts[node] ? first_children[node] + index : no_node;
+        }
+
+        std::uint32_t depth(node_id node) const { return depths[node]; }
+
+        bool is_leaf(node_id node) const { return child_counts[node] == 0; }
+
+        // The child indices from the root down to node, and back.
+        std::vector<std::uint32_t> path(node_id node) const {
+            std::vector<std::uint32_t> indices(depths[node]);
+            for (node_id current = node; parents[current] != no_node; current = parents[current])
+                indices[depths[current] - 1] = current - first_children[parents[current]];
+            return indices;
+        }
+
+        node_id find(const std::vector<std::uint32_t> & indices) const {
+            node_id current = root();
+            for (std::uint32_t index : indices) {
+                current = child(current, index);
+                if (current == no_node)
+                    return no_node;
+            }
+            return current;
+        }
+
+        bool is_in_frontier(node_id node) const { return frontier_prev[node] != no_node or frontier_head == node; }
+
+        std::size_t frontier_size() const { return frontier_count; }
+
+        // The open leaves, in tree order of their partitions; partitioning or solving nodes invalidates iterators.
+        class frontier_iterator {
+            const PartitionTree * tree = nullptr;
+            node_id node = no_node;
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = node_id;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const node_id *;
+            using reference = node_id;
+
+            frontier_iterator() = default;
+
+            frontier_iterator(const PartitionTree * _tree, node_id _node) : tree(_tree), node(_node) {}
+
+            node_id operator*() const { return node; }
+
+            frontier_iterator & operator++() {
+                node = tree->frontier_next[node];
+                return *this;
+            }
+
+            frontier_iterator operator++(int) {
+                frontier_iterator old = *this;
+                ++*this;
+                return old;
+            }
+
+            bool operator==(const frontier_iterator & other) const { return node == other.node; }
+
+            bool operator!=(const frontier_iterator & other) const { return node != other.node; }
+        };
+
+        struct frontier_range {
+            frontier_iterator first;
+
+            frontier_iterator begin() const { return first; }
+
+            frontier_iterator end() const { return frontier_iterator(); }
+        };
+
+        frontier_range frontier() const { return frontier_range{frontier_iterator(this, frontier_head)}; }
+    };
+}
+
+#endif // PTPLIB_TREE_PARTITIONTREE_HPP
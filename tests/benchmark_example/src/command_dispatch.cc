@@ -0,0 +1,73 @@
+//
+// Dispatching events on their command: the chain of header.at(Param.COMMAND) == Command.X comparisons against a switch
+// on the CommandId parsed through the compile-time perfect hash.
+//
+
+#include <PTPLib/common/PartitionConstant.hpp>
+#include <PTPLib/common/Printer.hpp>
+#include <PTPLib/net/SMTSEvent.hpp>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+using bench_clock = std::chrono::steady_clock;
+
+static int dispatch_strings(const PTPLib::net::SMTS_Event & event) {
+    if (event.header.at(PTPLib::common::Param.COMMAND) == PTPLib::common::Command.STOP)
+        return 1;
+    else if (event.header.at(PTPLib::common::Param.COMMAND) == PTPLib::common::Command.SOLVE)
+        return 2;
+    else if (event.header.at(PTPLib::common::Param.COMMAND) == PTPLib::common::Command.PARTITION)
+        return 3;
+    else if (event.header.at(PTPLib::common::Param.COMMAND) == PTPLib::common::Command.CLAUSEINJECTION)
+        return 4;
+    else if (event.header.at(PTPLib::common::Param.COMMAND) == PTPLib::common::Command.INCREMENTAL)
+        return 5;
+    return 0;
+}
+
+static int dispatch_id(const PTPLib::net::SMTS_Event & event) {
+    switch (event.command) {
+        case PTPLib::common::CommandId::STOP:            return 1;
+        case PTPLib::common::CommandId::SOLVE:           return 2;
+        case PTPLib::common::CommandId::PARTITION:       return 3;
+        case PTPLib::common::CommandId::CLAUSEINJECTION: return 4;
+        case PTPLib::common::CommandId::INCREMENTAL:     return 5;
+        default:                                         return 0;
+    }
+}
+
+template<typename F>
+static double time_ns(const std::vector<PTPLib::net::SMTS_Event> & events, int rounds, F && f) {
+    auto start = bench_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (auto & event : events)
+            f(event);
+    }
+    return std::chrono::duration<double, std::nano>(bench_clock::now() - start).count()
+           / (static_cast<double>(rounds) * static_cast<double>(events.size()));
+}
+
+int main() {
+    PTPLib::common::synced_stream stream;
+    std::vector<PTPLib::net::SMTS_Event> events;
+    for (int i = 0; i < 1000; ++i) {
+        PTPLib::net::Header header;
+        header[PTPLib::common::Param.NAME] = "instance.smt2";
+        header[PTPLib::common::Param.NODE] = "[" + std::to_string(i) + "]";
+        header[PTPLib::common::Param.QUERY] = "(check-sat)";
+        header[PTPLib::common::Param.COMMAND] = std::string(PTPLib::common::COMMAND_NAMES[static_cast<std::size_t>(i) % PTPLib::common::COMMAND_NAMES.size()]);
+        events.emplace_back(std::move(header), "");
+    }
+    const int rounds = 2000;
+    long sink = 0;
+    const double strings_ns = time_ns(events, rounds, [&](const PTPLib::net::SMTS_Event & event) { sink += dispatch_strings(event); });
+    const double parse_ns = time_ns(events, rounds, [&](const PTPLib::net::SMTS_Event & event) {
+        sink += static_cast<long>(PTPLib::common::command_id(event.header.at(PTPLib::common::Param.COMMAND)));
+    });
+    const double id_ns = time_ns(events, rounds, [&](const PTPLib::net::SMTS_Event & event) { sink += dispatch_id(event); });
+    stream.println(PTPLib::common::Color::FG_BrightCyan, "string comparisons: ", strings_ns, " ns/event\tcommand_id: ",
+                   parse_ns, " ns/event\tswitch on CommandId: ", id_ns, " ns/event\t(", sink != 0, ")");
+    return 0;
+}
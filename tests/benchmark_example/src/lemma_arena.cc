@@ -0,0 +1,74 @@
+//
+// Cost of filling a channel's pulled lemma buffer and throwing it away, as the pull thread and the solver do every
+// round, with lemmas owning their clause strings against ArenaLemma clauses copied into the buffer's arena.
+//
+
+#include <PTPLib/common/Printer.hpp>
+#include <PTPLib/common/PartitionConstant.hpp>
+#include <PTPLib/net/Channel.hpp>
+#include <PTPLib/net/Header.hpp>
+#include <PTPLib/net/LemmaArena.hpp>
+#include <PTPLib/net/SMTSEvent.hpp>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+using bench_clock = std::chrono::steady_clock;
+
+// The clauses of one pull, one per line, as they arrive in a single payload.
+static std::vector<std::string_view> split_lines(const std::string & payload) {
+    std::vector<std::string_view> lines;
+    std::size_t begin = 0;
+    for (std::size_t end; (end = payload.find('\n', begin)) != std::string::npos; begin = end + 1)
+        lines.emplace_back(payload.data() + begin, end - begin);
+    return lines;
+}
+
+template<typename LEMMA>
+static double run(const std::vector<std::string_view> & clauses, int instances, int rounds, std::size_t & checksum) {
+    PTPLib::net::Channel<PTPLib::net::SMTS_Event, LEMMA> channel;
+    PTPLib::net::Header header;
+    auto start = bench_clock::now();
+    for (int instance = 0; instance < instances; ++instance) {
+        header[PTPLib::common::Param.NAME] = "instance" + std::to_string(instance);
+        header[PTPLib::common::Param.NODE] = "[0]";
+        std::scoped_lock<PTPLib::net::channel_mutex> lock(channel.getMutex());
+        channel.set_current_header(header);
+        for (int round = 0; round < rounds; ++round) {
+            std::vector<LEMMA> lemmas;
+            lemmas.reserve(clauses.size());
+            for (std::size_t i = 0; i < clauses.size(); ++i) {
+                if constexpr (std::is_same_v<LEMMA, PTPLib::net::Lemma>)
+                    lemmas.emplace_back(std::string(clauses[i]), static_cast<int>(i % 10));
+                else
+                    lemmas.emplace_back(clauses[i], static_cast<int>(i % 10));
+            }
+            channel.insert_pulled_clause(std::move(lemmas));
+            auto pulled = channel.swap_pulled_clauses();
+            checksum += pulled->begin()->second.back().clause.size();
+        }
+        channel.resetChannel();
+    }
+    return std::chrono::duration<double, std::nano>(bench_clock::now() - start).count()
+           / (static_cast<double>(instances) * rounds * static_cast<double>(clauses.size()));
+}
+
+int main() {
+    PTPLib::common::synced_stream stream;
+    std::string payload;
+    for (int i = 0; i < 2000; ++i)
+        payload += "(assert (or (not b" + std::to_string(i) + ") (= x" + std::to_string(i % 97) + " 0)))\n";
+    const auto clauses = split_lines(payload);
+    const int instances = 20;
+    const int rounds = 100;
+    std::size_t checksum = 0;
+    const double owned_ns = run<PTPLib::net::Lemma>(clauses, instances, rounds, checksum);
+    const double arena_ns = run<PTPLib::net::ArenaLemma>(clauses, instances, rounds, checksum);
+    stream.println(PTPLib::common::Color::FG_BrightCyan, "lemmas per round: ", clauses.size(),
+                   "\tLemma: ", owned_ns, " ns/lemma\tArenaLemma: ", arena_ns, " ns/lemma\t(", checksum != 0, ")");
+    return 0;
+}
@@ -0,0 +1,61 @@
+//
+// Compares the cost per log record of synced_stream (text formatting under the stream lock) against binary_log
+// (raw argument bytes into a buffer), both writing into a stream that discards its output.
+//
+
+#include <PTPLib/common/Printer.hpp>
+#include <PTPLib/common/BinaryLog.hpp>
+
+#include <chrono>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+using bench_clock = std::chrono::steady_clock;
+
+class null_buffer : public std::streambuf {
+protected:
+    int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+
+    std::streamsize xsputn(const char *, std::streamsize n) override { return n; }
+};
+
+template<typename LOG_RECORD>
+static double run(unsigned thread_count, int records_per_thread, LOG_RECORD log_record) {
+    auto start = bench_clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&log_record, records_per_thread] {
+            const std::string node = "[0, 1, 3]";
+            for (int i = 0; i < records_per_thread; ++i)
+                log_record(i, node);
+        });
+    }
+    for (auto & thread : threads)
+        thread.join();
+    return std::chrono::duration<double, std::nano>(bench_clock::now() - start).count() / (thread_count * records_per_thread);
+}
+
+int main() {
+    PTPLib::common::synced_stream stream;
+    null_buffer discard;
+    std::ostream null_stream(&discard);
+    const int records_per_thread = 200000;
+    for (unsigned thread_count : {1u, 2u, 4u}) {
+        PTPLib::common::synced_stream text_log(null_stream);
+        const double text_ns = run(thread_count, records_per_thread, [&text_log](int i, const std::string & node) {
+            PTPLIB_LOG(text_log, Info, PUSH, PTPLib::common::Color::FG_Blue,
+                       "[t PUSH ] -> push learned clauses to Cloud, node: ", node, " Size: ", i, " ratio: ", i * 0.5);
+        });
+        PTPLib::common::binary_log binary(null_stream);
+        const double binary_ns = run(thread_count, records_per_thread, [&binary](int i, const std::string & node) {
+            PTPLIB_BLOG(binary, Info, PUSH, PTPLib::common::Color::FG_Blue,
+                        "[t PUSH ] -> push learned clauses to Cloud, node: {} Size: {} ratio: {}", node, i, i * 0.5);
+        });
+        stream.println(PTPLib::common::Color::FG_BrightCyan, "threads: ", thread_count, "\tsynced_stream: ", text_ns,
+                       " ns/record\tbinary_log: ", binary_ns, " ns/record");
+    }
+    return 0;
+}
@@ -0,0 +1,91 @@
+//
+// Measures the latency of locking two of several shared safe_ptrs at once under contention:
+// lock_timed_any_once (spin, timed sleeps, gives up) against ordered_lock (address order, no sleeps).
+// lock_timed_any_infinity is left out: with the pairs taken in arbitrary order it can livelock.
+//
+
+#include <PTPLib/common/Printer.hpp>
+#include <PTPLib/threads/ThreadSafeContainer.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+using bench_clock = std::chrono::steady_clock;
+
+typedef PTPLib::threads::safe_ptr<std::vector<int>> counter_ptr;
+
+struct run_result {
+    std::vector<long long> latencies;
+    std::size_t failed = 0;
+};
+
+// Each thread repeatedly locks a random pair of counters, in random argument order, for duration.
+template<typename LOCK_PAIR>
+static run_result run(unsigned thread_count, std::chrono::milliseconds duration, LOCK_PAIR lock_pair) {
+    std::vector<counter_ptr> counters;
+    for (int i = 0; i < 4; ++i)
+        counters.emplace_back(1, 0);
+    std::vector<run_result> results(thread_count);
+    std::atomic<bool> stop = false;
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t] {
+            std::mt19937 rng(t);
+            while (not stop.load(std::memory_order_relaxed)) {
+                const std::size_t a = rng() % counters.size();
+                const std::size_t b = (a + 1 + rng() % (counters.size() - 1)) % counters.size();
+                auto start = bench_clock::now();
+                if (not lock_pair(counters[a], counters[b]))
+                    results[t].failed++;
+                results[t].latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - start).count());
+            }
+        });
+    }
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for (auto & thread : threads)
+        thread.join();
+    run_result all;
+    for (auto & result : results) {
+        all.latencies.insert(all.latencies.end(), result.latencies.begin(), result.latencies.end());
+        all.failed += result.failed;
+    }
+    std::sort(all.latencies.begin(), all.latencies.end());
+    return all;
+}
+
+static long long percentile(const std::vector<long long> & sorted, double p) {
+    return sorted[std::min(sorted.size() - 1, static_cast<std::size_t>(p * sorted.size()))];
+}
+
+int main() {
+    PTPLib::common::synced_stream stream;
+    const std::chrono::milliseconds duration(500);
+    auto report = [&stream](const char * name, unsigned thread_count, const run_result & result) {
+        const auto & sorted = result.latencies;
+        stream.println(PTPLib::common::Color::FG_BrightCyan, name, "\tthreads: ", thread_count, "\tattempts: ", sorted.size(),
+                       "\tfailed: ", result.failed, "\tp50: ", percentile(sorted, 0.5), " ns\tp99: ", percentile(sorted, 0.99),
+                       " ns\tp99.9: ", percentile(sorted, 0.999), " ns\tmax: ", sorted.back(), " ns");
+    };
+    for (unsigned thread_count : {2u, 4u, 8u}) {
+        report("lock_timed_any", thread_count, run(thread_count, duration, [](counter_ptr & a, counter_ptr & b) {
+            PTPLib::threads::lock_timed_any_once lock(a, b);
+            if (not lock)
+                return false;
+            (*a)[0]++;
+            (*b)[0]++;
+            return true;
+        }));
+        report("ordered_lock  ", thread_count, run(thread_count, duration, [](counter_ptr & a, counter_ptr & b) {
+            PTPLib::threads::ordered_lock lock(a, b);
+            (*a)[0]++;
+            (*b)[0]++;
+            return true;
+        }));
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+//
+// to_string and the vector stream codecs on numbers through std::to_chars/std::from_chars, against the stream per
+// call (or per element) they used before.
+//
+
+#include <PTPLib/common/Lib.hpp>
+#include <PTPLib/common/Printer.hpp>
+
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using bench_clock = std::chrono::steady_clock;
+
+namespace legacy {
+    template<typename T>
+    std::string to_string(const T & obj) {
+        std::ostringstream ss;
+        ss << obj;
+        return ss.str();
+    }
+
+    template<typename T>
+    void write(std::ostream & stream, const std::vector<T> & v) {
+        for (auto & i : v)
+            stream << i << '\0';
+    }
+
+    template<typename T>
+    void read(std::istream & stream, std::vector<T> & v) {
+        std::string sub;
+        while (std::getline(stream, sub, '\0')) {
+            if (sub.size() == 0)
+                continue;
+            T t;
+            std::istringstream(sub) >> t;
+            v.push_back(t);
+        }
+    }
+}
+
+template<typename F>
+static double time_ns(int iterations, F && f) {
+    auto start = bench_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        f(i);
+    return std::chrono::duration<double, std::nano>(bench_clock::now() - start).count() / iterations;
+}
+
+int main() {
+    PTPLib::common::synced_stream stream;
+    const int calls = 1000000;
+    std::size_t sink = 0;
+    const double int_old = time_ns(calls, [&](int i) { sink += legacy::to_string(static_cast<long>(i) * 7919).size(); });
+    const double int_new = time_ns(calls, [&](int i) { sink += to_string(static_cast<long>(i) * 7919).size(); });
+    const double double_old = time_ns(calls, [&](int i) { sink += legacy::to_string(i * 0.37).size(); });
+    const double double_new = time_ns(calls, [&](int i) { sink += to_string(i * 0.37).size(); });
+    std::string buffer;
+    const double double_append = time_ns(calls, [&](int i) {
+        buffer.clear();
+        sink += append_string(buffer, i * 0.37).size();
+    });
+
+    std::vector<long> levels(1000);
+    for (std::size_t i = 0; i < levels.size(); ++i)
+        levels[i] = static_cast<long>(i * i);
+    const double codec_old = time_ns(1000, [&](int) {
+        std::stringstream ss;
+        legacy::write(ss, levels);
+        std::vector<long> decoded;
+        legacy::read(ss, decoded);
+        sink += decoded.size();
+    });
+    const double codec_new = time_ns(1000, [&](int) {
+        std::stringstream ss;
+        ss << levels;
+        std::vector<long> decoded;
+        ss >> decoded;
+        sink += decoded.size();
+    });
+
+    stream.println(PTPLib::common::Color::FG_BrightCyan, "to_string(long): ", int_old, " -> ", int_new,
+                   " ns\tto_string(double): ", double_old, " -> ", double_new, " ns (append_string: ", double_append, " ns)");
+    stream.println(PTPLib::common::Color::FG_BrightCyan, "vector<long> of ", levels.size(), " write+read: ",
+                   codec_old / 1e3, " -> ", codec_new / 1e3, " us\t(", sink != 0, ")");
+    return 0;
+}
@@ -0,0 +1,57 @@
+//
+// PartitionTree on millions of nodes: partitioning the frontier level by level, enumerating the frontier, and
+// propagating UNSAT results from random leaves.
+//
+
+#include <PTPLib/common/Printer.hpp>
+#include <PTPLib/tree/PartitionTree.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+using bench_clock = std::chrono::steady_clock;
+
+static double since_ns(bench_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(bench_clock::now() - start).count();
+}
+
+int main() {
+    PTPLib::common::synced_stream stream;
+    const std::size_t target = 1u << 20;
+    PTPLib::tree::PartitionTree tree(target * 2);
+    std::vector<PTPLib::tree::PartitionTree::node_id> leaves;
+
+    auto start = bench_clock::now();
+    std::size_t partitions = 0;
+    while (tree.size() < target) {
+        leaves.assign(tree.frontier().begin(), tree.frontier().end());
+        for (auto leaf : leaves) {
+            tree.partition(leaf, 2);
+            ++partitions;
+        }
+    }
+    const double partition_ns = since_ns(start) / static_cast<double>(partitions);
+
+    start = bench_clock::now();
+    std::size_t open = 0;
+    for (auto node : tree.frontier())
+        open += node != PTPLib::tree::PartitionTree::no_node;
+    const double frontier_ns = since_ns(start) / static_cast<double>(open);
+
+    leaves.assign(tree.frontier().begin(), tree.frontier().end());
+    std::shuffle(leaves.begin(), leaves.end(), std::mt19937(1));
+    start = bench_clock::now();
+    std::size_t results = 0;
+    for (auto leaf : leaves) {
+        tree.set_status(leaf, PTPLib::tree::node_status::UNSAT);
+        ++results;
+    }
+    const double unsat_ns = since_ns(start) / static_cast<double>(results);
+
+    stream.println(PTPLib::common::Color::FG_BrightCyan, "nodes: ", tree.size(), " depth: ", tree.depth(leaves.front()),
+                   "\tpartition: ", partition_ns, " ns\tfrontier of ", open, ": ", frontier_ns, " ns/leaf\tUNSAT on every leaf: ",
+                   unsat_ns, " ns/result, root ", tree.root_status() == PTPLib::tree::node_status::UNSAT ? "UNSAT" : "?");
+    return 0;
+}
@@ -0,0 +1,83 @@
+//
+// Lines per second of print_bold into a stream that discards its output: the previous per-line
+// std::time + std::localtime + std::put_time under the stream lock against the cached timestamp prefix.
+//
+
+#include <PTPLib/common/Printer.hpp>
+
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+using bench_clock = std::chrono::steady_clock;
+
+class null_buffer : public std::streambuf {
+protected:
+    int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+
+    std::streamsize xsputn(const char *, std::streamsize n) override { return n; }
+};
+
+// print_bold as it was: the timestamp is formatted for every line while the lock is held.
+class per_line_stream {
+    std::mutex stream_mutex;
+    std::ostream & out;
+
+public:
+    explicit per_line_stream(std::ostream & _out) : out(_out) {}
+
+    template<typename... T>
+    void println_bold(PTPLib::common::Color::Code colorCode, const T & ...items) {
+        const std::scoped_lock lock(stream_mutex);
+        std::time_t time = std::time(nullptr);
+        struct tm tm = *std::localtime(&time);
+        out << "\033[1m" << "\033[" << colorCode << "m";
+        (out << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << "\t");
+        (out << ... << items) << '\n';
+        out << "\033[0m";
+    }
+};
+
+template<typename STREAM>
+static double run(STREAM & stream, unsigned thread_count, int lines_per_thread) {
+    auto start = bench_clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&stream, lines_per_thread] {
+            for (int i = 0; i < lines_per_thread; ++i)
+                stream.println_bold(PTPLib::common::Color::FG_Green, "[t SEARCH ] -> solver status, conflicts: ", i);
+        });
+    }
+    for (auto & thread : threads)
+        thread.join();
+    return thread_count * lines_per_thread / std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+int main() {
+    PTPLib::common::synced_stream stream;
+    null_buffer discard;
+    std::ostream null_stream(&discard);
+    const int lines_per_thread = 200000;
+    for (unsigned thread_count : {1u, 4u}) {
+        per_line_stream before(null_stream);
+        const double before_lps = run(before, thread_count, lines_per_thread);
+        PTPLib::common::synced_stream after(null_stream);
+        double after_lps[3];
+        const PTPLib::common::timestamp_mode modes[3] = {PTPLib::common::timestamp_mode::seconds,
+                                                         PTPLib::common::timestamp_mode::milliseconds,
+                                                         PTPLib::common::timestamp_mode::monotonic};
+        for (int m = 0; m < 3; ++m) {
+            after.set_timestamp_mode(modes[m]);
+            after_lps[m] = run(after, thread_count, lines_per_thread);
+        }
+        stream.println(PTPLib::common::Color::FG_BrightCyan, std::fixed, std::setprecision(0), "threads: ", thread_count,
+                       "\tper line: ", before_lps, " lines/s\tcached s: ", after_lps[0], " lines/s\tcached ms: ",
+                       after_lps[1], " lines/s\tmonotonic: ", after_lps[2], " lines/s");
+    }
+    return 0;
+}
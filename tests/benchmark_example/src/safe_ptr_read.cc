@@ -0,0 +1,64 @@
+//
+// Compares read scaling of safe_ptr (exclusive locking) against shared_safe_ptr (shared locking for readers)
+// on a read-mostly map, for a growing number of threads.
+//
+
+#include <PTPLib/common/Printer.hpp>
+#include <PTPLib/threads/ThreadSafeContainer.hpp>
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using bench_clock = std::chrono::steady_clock;
+
+typedef std::map<int, std::string> index_map;
+
+template<typename SAFE_PTR>
+static double run(SAFE_PTR & index, unsigned thread_count, int ops_per_thread, int write_every) {
+    auto start = bench_clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&index, t, ops_per_thread, write_every] {
+            std::size_t sink = 0;
+            for (int i = 0; i < ops_per_thread; ++i) {
+                if (i % write_every == 0)
+                    index->insert_or_assign(static_cast<int>(t * 131 + i) % 1024, "lemma");
+                else {
+                    const SAFE_PTR & reader = index;
+                    sink += reader->count(i % 1024);
+                }
+            }
+            if (sink == std::size_t(-1))
+                std::abort();
+        });
+    }
+    for (auto & thread : threads)
+        thread.join();
+    const double seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+    return thread_count * ops_per_thread / seconds / 1e6;
+}
+
+int main() {
+    PTPLib::common::synced_stream stream;
+    const int ops_per_thread = 200000;
+    const int write_every = 20;
+    for (unsigned thread_count : {1u, 2u, 4u, 8u}) {
+        PTPLib::threads::safe_ptr<index_map> exclusive;
+        PTPLib::threads::counted_shared_safe_ptr<index_map> shared;
+        for (int i = 0; i < 1024; ++i) {
+            exclusive->emplace(i, "lemma");
+            shared->emplace(i, "lemma");
+        }
+        shared.get_mutex().reset_stats();
+        const double exclusive_mops = run(exclusive, thread_count, ops_per_thread, write_every);
+        const double shared_mops = run(shared, thread_count, ops_per_thread, write_every);
+        const auto stats = shared.get_mutex().get_stats();
+        stream.println(PTPLib::common::Color::FG_BrightCyan, "threads: ", thread_count,
+                       "\tsafe_ptr: ", exclusive_mops, " Mops/s\tshared_safe_ptr: ", shared_mops,
+                       " Mops/s\tacquisitions: ", stats.acquisitions, " contended: ", stats.contended);
+    }
+    return 0;
+}
@@ -0,0 +1,48 @@
+//
+// Cost of a StoppableWatch start/stop pair on tick_clock against the same pair on steady_clock with long double
+// accumulation, as StoppableWatch used to do it.
+//
+
+#include <PTPLib/common/Printer.hpp>
+#include <PTPLib/common/Timer.hpp>
+
+#include <chrono>
+
+using bench_clock = std::chrono::steady_clock;
+
+class steady_watch {
+    std::chrono::steady_clock::time_point reference;
+    std::chrono::duration<long double> accumulated{0};
+
+public:
+    void start() { reference = std::chrono::steady_clock::now(); }
+
+    void stop() {
+        accumulated += std::chrono::duration_cast<std::chrono::duration<long double>>(std::chrono::steady_clock::now() - reference);
+    }
+
+    long double seconds() const { return accumulated.count(); }
+};
+
+template<typename WATCH>
+static double run(WATCH & watch, int pairs) {
+    auto start = bench_clock::now();
+    for (int i = 0; i < pairs; ++i) {
+        watch.start();
+        watch.stop();
+    }
+    return std::chrono::duration<double, std::nano>(bench_clock::now() - start).count() / pairs;
+}
+
+int main() {
+    PTPLib::common::synced_stream stream;
+    const int pairs = 5000000;
+    steady_watch before;
+    PTPLib::common::StoppableWatch after;
+    const double before_ns = run(before, pairs);
+    const double after_ns = run(after, pairs);
+    stream.println(PTPLib::common::Color::FG_BrightCyan, "tsc: ", PTPLib::common::tick_clock::uses_tsc(),
+                   "\tsteady_clock start/stop: ", before_ns, " ns\ttick_clock start/stop: ", after_ns, " ns\t(",
+                   before.seconds() > 0, after.elapsed_ticks() > 0, ")");
+    return 0;
+}
@@ -0,0 +1,91 @@
+//
+// split_view, replace_all and the single-pass replace against split, replace and operator% as Lib.hpp used to
+// implement them: a std::function callback with a substr copy per piece, and string::replace per occurrence.
+//
+
+#include <PTPLib/common/Lib.hpp>
+#include <PTPLib/common/Printer.hpp>
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using bench_clock = std::chrono::steady_clock;
+
+namespace legacy {
+    void split(const std::string & string, const std::string & delimiter,
+               std::function<void(const std::string &)> callback, uint32_t limit = 0) {
+        size_t b = 0;
+        size_t e;
+        while (true) {
+            if (limit != 0 && --limit == 0)
+                e = std::string::npos;
+            else
+                e = string.find(delimiter, b);
+            callback(string.substr(b, e - b));
+            if (e == std::string::npos)
+                return;
+            b = e + delimiter.size();
+        }
+    }
+
+    std::vector<std::string> split(const std::string & string, const std::string & delimiter) {
+        std::vector<std::string> vector;
+        split(string, delimiter, [&vector](const std::string & sub) { vector.push_back(sub); });
+        return vector;
+    }
+
+    std::string & replace(std::string & string, std::string const & from, std::string const & to) {
+        size_t start_pos = 0;
+        while ((start_pos = string.find(from, start_pos)) != std::string::npos) {
+            string.replace(start_pos, from.length(), to);
+            start_pos += to.length();
+        }
+        return string;
+    }
+}
+
+template<typename F>
+static double time_ns(int iterations, F && f) {
+    auto start = bench_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        f();
+    return std::chrono::duration<double, std::nano>(bench_clock::now() - start).count() / iterations;
+}
+
+int main() {
+    PTPLib::common::synced_stream stream;
+    std::string node = "[";
+    for (int i = 0; i < 64; ++i)
+        node += std::to_string(i % 7) + ", " + std::to_string(i) + (i == 63 ? "]" : ", ");
+    std::string text;
+    for (int i = 0; i < 20000; ++i)
+        text += "(assert [b" + std::to_string(i) + "])\n";
+
+    std::size_t sink = 0;
+    const double split_old = time_ns(20000, [&] { sink += legacy::split(node, ",").size(); });
+    const double split_new = time_ns(20000, [&] {
+        for (std::string_view piece : split_view(node, ","))
+            sink += piece.size();
+    });
+    const double replace_old = time_ns(10, [&] {
+        std::string copy = text;
+        legacy::replace(legacy::replace(legacy::replace(copy, "[", ""), "]", ""), " ", "");
+        sink += copy.size();
+    });
+    const double replace_new = time_ns(10, [&] {
+        std::string copy = text;
+        replace(replace(replace(copy, "[", ""), "]", ""), " ", "");
+        sink += copy.size();
+    });
+    const double replace_all_ns = time_ns(10, [&] { sink += replace_all(text, {{"[", ""}, {"]", ""}, {" ", ""}}).size(); });
+
+    stream.println(PTPLib::common::Color::FG_BrightCyan, "split node path of ", node.size(), " bytes: ", split_old,
+                   " ns -> split_view: ", split_new, " ns");
+    stream.println(PTPLib::common::Color::FG_BrightCyan, "strip 3 patterns from ", text.size(), " bytes: replace was ",
+                   replace_old / 1e6, " ms, now ", replace_new / 1e6, " ms, replace_all: ", replace_all_ns / 1e6,
+                   " ms\t(", sink != 0, ")");
+    return 0;
+}
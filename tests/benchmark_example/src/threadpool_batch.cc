@@ -0,0 +1,45 @@
+//
+// Compares enqueuing tasks one by one against ThreadPool::submit_batch.
+//
+
+#include <PTPLib/threads/ThreadPool.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+using bench_clock = std::chrono::steady_clock;
+
+static long long micros_since(bench_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(bench_clock::now() - start).count();
+}
+
+int main() {
+    PTPLib::common::synced_stream stream;
+    PTPLib::threads::ThreadPool pool("benchmark_pool", std::max(1u, std::thread::hardware_concurrency() - 1));
+    pool.sleep_duration = 0;
+    std::atomic<std::size_t> sink = 0;
+    const int rounds = 5;
+
+    for (std::size_t batch_size : {10, 100, 1000, 10000}) {
+        std::vector<std::function<int()>> batch(batch_size, [&sink] { return (int) sink.fetch_add(1, std::memory_order_relaxed); });
+        long long single_us = 0, batch_us = 0;
+        for (int r = 0; r < rounds; ++r) {
+            auto start = bench_clock::now();
+            std::vector<std::future<int>> futures;
+            futures.reserve(batch_size);
+            for (auto & task : batch)
+                futures.push_back(pool.submit(task));
+            for (auto & future : futures)
+                future.get();
+            single_us += micros_since(start);
+
+            start = bench_clock::now();
+            pool.submit_batch(batch.begin(), batch.end()).get();
+            batch_us += micros_since(start);
+        }
+        stream.println(PTPLib::common::Color::FG_BrightCyan, "batch size: ", batch_size,
+                       "\tsubmit: ", single_us / rounds, " us\tsubmit_batch: ", batch_us / rounds, " us");
+    }
+    return 0;
+}
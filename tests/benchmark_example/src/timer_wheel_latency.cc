@@ -0,0 +1,63 @@
+//
+// TimerWheel lateness: how long after its deadline a timer fires when it is added to an idle wheel, with and without
+// a delay. Exits with an error if more than a tenth of the zero-delay timers on a wheel of 10 us ticks are a
+// lowest-level revolution (64 ticks) late, i.e. the wheel skipped their slot.
+//
+
+#include <PTPLib/common/Printer.hpp>
+#include <PTPLib/threads/TimerWheel.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+using bench_clock = std::chrono::steady_clock;
+
+// Adds one timer to the idle wheel and returns how many microseconds after its deadline it ran.
+static double lateness_us(PTPLib::threads::TimerWheel & wheel, bench_clock::duration delay) {
+    std::promise<bench_clock::time_point> fired;
+    auto future = fired.get_future();
+    const auto deadline = bench_clock::now() + delay;
+    wheel.schedule_after(delay, [&fired] { fired.set_value(bench_clock::now()); });
+    return std::chrono::duration<double, std::micro>(future.get() - deadline).count();
+}
+
+struct lateness_stats {
+    double median_us;
+    double max_us;
+    int later_than_limit;
+};
+
+// Lateness over rounds timers, letting the wheel run empty before each.
+static lateness_stats lateness(PTPLib::threads::TimerWheel & wheel, bench_clock::duration delay, int rounds, double limit_us = 0) {
+    std::vector<double> samples;
+    for (int i = 0; i < rounds; ++i) {
+        std::this_thread::sleep_for(std::chrono::microseconds(300 + 37 * (i % 27)));
+        samples.push_back(lateness_us(wheel, delay));
+    }
+    const int late = static_cast<int>(std::count_if(samples.begin(), samples.end(), [limit_us](double us) { return us > limit_us; }));
+    std::nth_element(samples.begin(), samples.begin() + rounds / 2, samples.end());
+    return {samples[rounds / 2], *std::max_element(samples.begin(), samples.end()), late};
+}
+
+int main() {
+    PTPLib::common::synced_stream stream;
+    const int rounds = 200;
+    PTPLib::threads::TimerWheel wheel;
+    const auto zero = lateness(wheel, bench_clock::duration(0), rounds);
+    const auto delayed = lateness(wheel, std::chrono::milliseconds(5), rounds);
+    PTPLib::threads::TimerWheel fine_wheel(std::chrono::microseconds(10));
+    const auto fine = lateness(fine_wheel, bench_clock::duration(0), rounds, 60 * 10);
+
+    stream.println(PTPLib::common::Color::FG_BrightCyan, "timers: ", rounds, "\tzero delay late by: median ", zero.median_us,
+                   " us, max ", zero.max_us, " us\t5 ms delay: median ", delayed.median_us, " us, max ", delayed.max_us,
+                   " us\tzero delay on 10 us ticks: median ", fine.median_us, " us, max ", fine.max_us, " us, ",
+                   fine.later_than_limit, " later than 60 ticks");
+    if (fine.later_than_limit > rounds / 10) {
+        stream.println(PTPLib::common::Color::FG_Red, "TimerWheel skips the slot of timers added to an idle wheel");
+        return 1;
+    }
+    return 0;
+}
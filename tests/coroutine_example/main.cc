@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2022, Seyedmasoud Asadzadeh <seyedmasoud.asadzadeh@usi.ch>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <PTPLib/net/Channel.hpp>
+#include <PTPLib/net/Lemma.hpp>
+#include <PTPLib/threads/Coroutine.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+typedef PTPLib::net::Channel<PTPLib::net::SMTS_Event, PTPLib::net::Lemma> channel_t;
+using std::chrono::steady_clock;
+
+static void expect(bool condition, const char * what) {
+    if (condition)
+        return;
+    std::cerr << "Coroutine-Example: " << what << " failed" << std::endl;
+    std::exit(1);
+}
+
+PTPLib::threads::task<int> square_later(PTPLib::threads::ThreadPool & pool, int value) {
+    co_await PTPLib::threads::sleep_for(pool, 20ms);
+    co_return value * value;
+}
+
+PTPLib::threads::task<int> sum_of_squares(PTPLib::threads::ThreadPool & pool) {
+    int sum = 0;
+    for (int i = 1; i <= 3; ++i)
+        sum += co_await square_later(pool, i);
+    co_return sum;
+}
+
+// Times out while spurious notifications keep waking it, then returns once the channel is reset.
+PTPLib::threads::task<> reset_waiter(PTPLib::threads::ThreadPool & pool, channel_t & channel) {
+    const auto start = steady_clock::now();
+    bool reset = co_await PTPLib::threads::wait_for_reset(pool, channel, 100ms);
+    expect(not reset, "wait_for_reset without a reset");
+    expect(steady_clock::now() - start >= 100ms, "wait_for_reset timeout");
+    reset = co_await PTPLib::threads::wait_for_reset(pool, channel, 10s);
+    expect(reset, "wait_for_reset with a reset");
+}
+
+int main() {
+    PTPLib::threads::ThreadPool pool("coroutine pool", 2);
+    channel_t channel;
+
+    auto sum = PTPLib::threads::co_spawn(pool, sum_of_squares(pool));
+    auto waiter = PTPLib::threads::co_spawn(pool, reset_waiter(pool, channel));
+
+    for (int i = 0; i < 20; ++i) {
+        std::this_thread::sleep_for(10ms);
+        channel.notify_all();
+    }
+    // Only the timer of the wait in progress is pending, not one per spurious wakeup.
+    expect(pool.get_timer_wheel().size() <= 1, "one timer per wait");
+    {
+        std::scoped_lock lock(channel.getMutex());
+        channel.setReset();
+    }
+    channel.notify_all();
+
+    waiter.get();
+    const int total = sum.get();
+    expect(total == 14, "sum_of_squares");
+    std::cout << "Coroutine-Example: sum of squares " << total << ", reset observed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,27 @@
+//
+// Prints a binary log written by PTPLib::common::binary_log as colored text.
+//
+
+#include <PTPLib/common/BinaryLog.hpp>
+
+#include <fstream>
+#include <string>
+
+int main(int argc, char** argv) {
+    PTPLib::common::synced_stream stream;
+    if (argc < 2) {
+        stream.println(PTPLib::common::Color::FG_BrightBlue, "Usage: ", argv[0], " <binary log> [--time]");
+        return 1;
+    }
+    std::ifstream in(argv[1], std::ios::binary);
+    if (not in) {
+        stream.println(PTPLib::common::Color::FG_Red, "cannot open ", argv[1]);
+        return 1;
+    }
+    PTPLib::common::binary_log_decoder decoder(in);
+    if (not decoder.decode(stream, argc > 2 and std::string(argv[2]) == "--time")) {
+        stream.println(PTPLib::common::Color::FG_Red, argv[1], " is not a binary log or is truncated");
+        return 1;
+    }
+    return 0;
+}
@@ -3,6 +3,9 @@
 //
 
 #include <PTPLib/common/Printer.hpp>
+#include <PTPLib/common/BinaryLog.hpp>
+
+#include <fstream>
 
 int main() {
     PTPLib::common::synced_stream stream;
@@ -10,5 +13,12 @@ int main() {
     stream.println(PTPLib::common::Color::FG_BrightCyan, "bar");
     stream.print(PTPLib::common::Color::BG_BrightCyan, "   ");
     stream.println(PTPLib::common::Color::BG_BrightYellow, "   ");
+
+    // The same kind of output as a binary log; PTP-Log-Decoder example.blog prints it back.
+    std::ofstream file("example.blog", std::ios::binary);
+    PTPLib::common::binary_log log(file);
+    for (int i = 0; i < 3; ++i)
+        PTPLIB_BLOG(log, Info, PUSH, PTPLib::common::Color::FG_Blue, "[t PUSH ] -> push learned clauses, Size: {}", i * 10);
+    PTPLIB_BLOG(log, Warn, PULL, PTPLib::common::Color::FG_Magenta, "[t PULL ] -> {} {} ({})", "spurious wake up!", 0.5, true);
     return 0;
-}
\ No newline at end of file
+}
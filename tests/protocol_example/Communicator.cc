@@ -12,7 +12,7 @@ void Communicator::communicate_worker()
     thread_id = std::this_thread::get_id();
     while (true)
     {
-        std::unique_lock<std::mutex> lk(channel.getMutex());
+        std::unique_lock<PTPLib::net::channel_mutex> lk(channel.getMutex());
         getChannel().wait_event_solver_reset(lk);
         assert([&]() {
             if (thread_id != std::this_thread::get_id())
@@ -37,9 +37,9 @@ void Communicator::communicate_worker()
         } else if (not getChannel().isEmpty_event()) {
             auto event = getChannel().pop_front_event();
             assert(not event.header[PTPLib::common::Param.COMMAND].empty());
-            stream.println(color_enabled ? PTPLib::common::Color::FG_Cyan : PTPLib::common::Color::FG_DEFAULT,
-                            "[t COMMUNICATOR ] -> ", "updating the channel with ",
-                           event.header.at(PTPLib::common::Param.COMMAND), " and waiting");
+            PTPLIB_LOG(stream, Info, COMMUNICATOR, color_enabled ? PTPLib::common::Color::FG_Cyan : PTPLib::common::Color::FG_DEFAULT,
+                       "[t COMMUNICATOR ] -> ", "updating the channel with ",
+                       event.header.at(PTPLib::common::Param.COMMAND), " and waiting");
             lk.unlock();
 
             if (setStop(event)) {
@@ -50,7 +50,7 @@ void Communicator::communicate_worker()
             bool should_resume;
             bool shouldUpdateSolverAddress = false;
             {
-                std::scoped_lock<std::mutex> slk(channel.getMutex());
+                std::scoped_lock<PTPLib::net::channel_mutex> slk(channel.getMutex());
                 should_resume = execute_event(event, shouldUpdateSolverAddress);
                 if (shouldUpdateSolverAddress) {
                     channel.clear_current_header();
@@ -61,9 +61,9 @@ void Communicator::communicate_worker()
             if (should_resume) {
                 getChannel().clearShouldStop();
                 channel.clearShallStop();
-                future = th_pool.submit([this, event] {
+                future = th_pool.submit([this, event](PTPLib::threads::stop_token token) {
                     assert(not event.header.at(PTPLib::common::Param.QUERY).empty());
-                    return solver.search((char *) (event.body + event.header.at(PTPLib::common::Param.QUERY)).c_str());
+                    return solver.search(token, (char *) (event.body + event.header.at(PTPLib::common::Param.QUERY)).c_str());
                 }, ::get_task_name(PTPLib::common::TASK::SOLVER));
             } else
                 break;
@@ -72,8 +72,8 @@ void Communicator::communicate_worker()
             break;
 
         else {
-            stream.println(color_enabled ? PTPLib::common::Color::FG_Cyan : PTPLib::common::Color::FG_DEFAULT,
-                           "[t COMMUNICATOR ] -> ", "spurious wake up!");
+            PTPLIB_LOG(stream, Warn, COMMUNICATOR, color_enabled ? PTPLib::common::Color::FG_Cyan : PTPLib::common::Color::FG_DEFAULT,
+                       "[t COMMUNICATOR ] -> ", "spurious wake up!");
             assert(false);
         }
     }
@@ -83,25 +83,34 @@ void Communicator::communicate_worker()
 bool Communicator::execute_event(const PTPLib::net::SMTS_Event & event, bool & shouldUpdateSolverAddress)
 {
     assert(not event.header.at(PTPLib::common::Param.COMMAND).empty());
-    if (event.header.at(PTPLib::common::Param.COMMAND) == PTPLib::common::Command.STOP)
-        return false;
+    switch (event.command) {
+        case PTPLib::common::CommandId::STOP:
+            return false;
 
-    else if (event.header.at(PTPLib::common::Param.COMMAND) == PTPLib::common::Command.SOLVE) {
-        solver.initialise_logic();
-        shouldUpdateSolverAddress = true;
-    }
+        case PTPLib::common::CommandId::SOLVE:
+            solver.initialise_logic();
+            shouldUpdateSolverAddress = true;
+            break;
+
+        case PTPLib::common::CommandId::PARTITION:
+            solver.do_partition(event.header.at(PTPLib::common::Param.NODE), event.header.at(PTPLib::common::Param.PARTITIONS));
+            break;
 
-    else if (event.header.at(PTPLib::common::Param.COMMAND) == PTPLib::common::Command.PARTITION)
-        solver.do_partition(event.header.at(PTPLib::common::Param.NODE), event.header.at(PTPLib::common::Param.PARTITIONS));
+        case PTPLib::common::CommandId::CLAUSEINJECTION: {
+            auto pulled_clauses = channel.swap_pulled_clauses();
+            solver.inject_clauses(*pulled_clauses);
+            break;
+        }
 
-    else if (event.header.at(PTPLib::common::Param.COMMAND) == PTPLib::common::Command.CLAUSEINJECTION) {
-        auto pulled_clauses = channel.swap_pulled_clauses();
-        solver.inject_clauses(*pulled_clauses);
+        case PTPLib::common::CommandId::INCREMENTAL:
+            shouldUpdateSolverAddress = true;
+            break;
 
-    } else if (event.header.at(PTPLib::common::Param.COMMAND) == PTPLib::common::Command.INCREMENTAL)
-        shouldUpdateSolverAddress = true;
+        default:
+            break;
+    }
 
-    if (not channel.isEmpty_event() and channel.front_event() == PTPLib::common::Command.STOP)
+    if (not channel.isEmpty_event() and channel.front_command() == PTPLib::common::CommandId::STOP)
         return false;
 
     return true;
@@ -111,8 +120,9 @@ bool Communicator::execute_event(const PTPLib::net::SMTS_Event & event, bool & s
 bool Communicator::setStop(PTPLib::net::SMTS_Event & event)
 {
     assert(not event.header.at(PTPLib::common::Param.COMMAND).empty());
-    if (event.header.at(PTPLib::common::Param.COMMAND) != PTPLib::common::Command.SOLVE) {
+    if (event.command != PTPLib::common::CommandId::SOLVE) {
         channel.setShouldStop();
+        future.request_stop();
         return true;
     }
     else
@@ -16,7 +16,7 @@ class Communicator {
     PTPLib::common::StoppableWatch timer;
     bool color_enabled;
     PTPLib::threads::ThreadPool & th_pool;
-    std::future<SMTSolver::Result> future;
+    PTPLib::threads::task_handle<SMTSolver::Result> future;
     std::atomic<std::thread::id> thread_id;
 
 public:
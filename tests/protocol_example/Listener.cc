@@ -1,7 +1,6 @@
 #include "Listener.h"
 #include "SMTSolver.h"
 
-#include <PTPLib/common/Memory.hpp>
 #include "PTPLib/net/Lemma.hpp"
 #include <PTPLib/common/Exception.hpp>
 
@@ -13,31 +12,49 @@
 
 void Listener::memory_checker()
 {
-    memory_thread_id = std::this_thread::get_id();
     size_t limit = 4000;//atoll(max_memory.c_str());
     if (limit == 0)
         return;
 
-    while (true) {
-        size_t memory_size_b = PTPLib::common::current_memory();
-        if (memory_size_b > limit * 1024 * 1024) {
-            stream.println(color_enabled ? PTPLib::common::Color::FG_Yellow : PTPLib::common::Color::FG_DEFAULT, "[t max memory checker ] -> max memory reached: ", std::to_string(memory_size_b));
-                exit(-1);
+    auto monitor = std::make_shared<memory_monitor>(limit * 3 / 4 * 1024 * 1024, limit * 1024 * 1024);
+    monitor->budget.track("Channel::learned_clauses", channel.learned_clauses_memory());
+    monitor->budget.track("Channel::pulled_clauses", channel.pulled_clauses_memory());
+    monitor->budget.track("synced_stream::pending", stream.pending_memory());
+    auto shed = [this](PTPLib::common::MemoryBudget::pressure pressure, std::size_t rss) {
+        std::size_t freed;
+        {
+            std::scoped_lock<PTPLib::net::channel_mutex> lk(channel.getMutex());
+            freed = channel.shed_pulled_clauses(pressure == PTPLib::common::MemoryBudget::pressure::HARD
+                                                ? 0 : channel.pulled_clauses_memory().get() / 2);
         }
-        stream.println(color_enabled ? PTPLib::common::Color::FG_Yellow : PTPLib::common::Color::FG_DEFAULT, "[t max memory checker ] -> ", std::to_string(memory_size_b));
-        std::unique_lock<std::mutex> lk(channel.getMutex());
-        if (channel.wait_for_reset(lk, std::chrono::seconds (10)))
-            break;
-        assert([&]() {
-            if (memory_thread_id != std::this_thread::get_id())
-                throw PTPLib::common::Exception(__FILE__, __LINE__, "memory_checker has inconsistent thread id");
-
-            if (not lk.owns_lock()) {
-                throw PTPLib::common::Exception(__FILE__, __LINE__, "memory_checker can't take the lock");
-            }
-            return true;
-        }());
+        PTPLIB_LOG(stream, Warn, MEMORY, color_enabled ? PTPLib::common::Color::FG_Yellow : PTPLib::common::Color::FG_DEFAULT,
+                   "[t max memory checker ] -> memory pressure at: ", rss, " shed pulled clauses: ", freed);
+    };
+    monitor->budget.on_soft_limit(shed);
+    monitor->budget.on_hard_limit(shed);
+    monitor->watcher.emplace(monitor->budget);
+    monitor->watcher->on_pressure([shed](PTPLib::common::MemoryPressureWatcher::source, PTPLib::common::MemoryBudget::pressure pressure) {
+        if (pressure == PTPLib::common::MemoryBudget::pressure::NORMAL)
+            shed(PTPLib::common::MemoryBudget::pressure::SOFT, PTPLib::common::current_memory());
+    });
+
+    PTPLib::threads::stop_token token;
+    {
+        std::scoped_lock<PTPLib::net::channel_mutex> lk(channel.getMutex());
+        if (getChannel().shouldReset())
+            return;
+        memory = monitor;
+        token = getChannel().reset_token();
     }
+    PTPLIB_LOG(stream, Debug, MEMORY, color_enabled ? PTPLib::common::Color::FG_Yellow : PTPLib::common::Color::FG_DEFAULT,
+               "[t max memory checker ] -> ", PTPLib::common::current_memory(), " tracked: ", monitor->budget.tracked_total());
+    // notify_reset drops the monitor, so the timer only holds it while a report is running.
+    th_pool.schedule_every(std::chrono::seconds(10), [this, weak = std::weak_ptr<memory_monitor>(monitor)]
+    {
+        if (auto monitor = weak.lock())
+            PTPLIB_LOG(stream, Debug, MEMORY, color_enabled ? PTPLib::common::Color::FG_Yellow : PTPLib::common::Color::FG_DEFAULT,
+                       "[t max memory checker ] -> ", PTPLib::common::current_memory(), " tracked: ", monitor->budget.tracked_total());
+    }, "MEMORYCHECK", token);
 }
 
 void Listener::worker(PTPLib::common::TASK wname, double seed, double td_min, double td_max) {
@@ -78,7 +95,7 @@ void Listener::push_to_pool(PTPLib::common::TASK t_name, double seed, double td_
 
 void Listener::notify_reset()
 {
-    std::unique_lock<std::mutex> _lk(getChannel().getMutex());
+    std::unique_lock<PTPLib::net::channel_mutex> _lk(getChannel().getMutex());
     assert([&]() {
         if (not _lk.owns_lock()) {
             throw PTPLib::common::Exception(__FILE__, __LINE__, "listener can't take the lock");
@@ -87,14 +104,22 @@ void Listener::notify_reset()
     }());
     channel.setReset();
     channel.notify_all();
+    // The watcher's shed takes the channel mutex, so it is stopped only once the lock is released.
+    auto retired = std::move(memory);
     _lk.unlock();
 }
 
+PTPLib::threads::stop_token Listener::reset_token()
+{
+    std::scoped_lock<PTPLib::net::channel_mutex> lk(channel.getMutex());
+    return getChannel().reset_token();
+}
+
 template<class T>
 bool Listener::queue_event(T && event)
 {
     bool reset = false;
-    if (event.header[PTPLib::common::Param.COMMAND] == PTPLib::common::Command.STOP) {
+    if (event.command == PTPLib::common::CommandId::STOP) {
         reset = true;
         getChannel().push_front_event(std::forward<T>(event));
     }
@@ -153,127 +178,104 @@ PTPLib::net::SMTS_Event Listener::generate_event(int counter, int time_passed)
 
 void Listener::push_clause_worker(double seed, double min, double max)
 {
-    push_thread_id = std::this_thread::get_id();
     int push_duration = (waiting_duration ? waiting_duration*(100) :  min + ( std::fmod(seed, ( max - min + 1 ))));
-    stream.println(color_enabled ? PTPLib::common::Color::FG_Blue : PTPLib::common::Color::FG_DEFAULT,
-                   "[t PUSH -> timout : ", push_duration," ms");
-    PTPLib::net::time_duration wakeupAt = std::chrono::milliseconds (push_duration);
-    while (true) {
-        PTPLib::common::PrintStopWatch psw("[t PUSH ] -> measured wait and write duration: ", stream,
-                                   color_enabled ? PTPLib::common::Color::FG_Blue : PTPLib::common::Color::FG_DEFAULT);
-        std::unique_lock<std::mutex> lk(getChannel().getMutex());
-        bool reset = getChannel().wait_for_reset(lk, wakeupAt);
+    PTPLIB_LOG(stream, Info, PUSH, color_enabled ? PTPLib::common::Color::FG_Blue : PTPLib::common::Color::FG_DEFAULT,
+               "[t PUSH -> timout : ", push_duration," ms");
+    const auto push_scope = latencies.scope("[t PUSH ] -> write");
+    // The timer wheel drives the period and the channel's reset cancels it, so no worker sits waiting for reset.
+    th_pool.schedule_every(std::chrono::milliseconds(push_duration), [this, push_scope]
+    {
+        PTPLib::common::ScopedLatencyRecorder recorder(latencies, push_scope);
+        std::unique_lock<PTPLib::net::channel_mutex> lk(getChannel().getMutex());
         assert([&]() {
-            if (push_thread_id != std::this_thread::get_id())
-                throw PTPLib::common::Exception(__FILE__, __LINE__, "push_clause_worker has inconsistent thread id");
-
             if (not lk.owns_lock()) {
                 throw PTPLib::common::Exception(__FILE__, __LINE__, "push_clause_worker can't take the lock");
             }
             return true;
         }());
-        if (not reset)
+        if (getChannel().shouldReset())
+            return;
+
+        if (not getChannel().empty_learned_clauses())
         {
-            if (not getChannel().empty_learned_clauses())
-            {
-                auto m_clauses = getChannel().swap_learned_clauses();
-                getChannel().clear_learned_clauses();
-                auto header = getChannel().get_current_header();
-                lk.unlock();
-                assert([&]() {
-                    if (lk.owns_lock()) {
-                        throw PTPLib::common::Exception(__FILE__, __LINE__, "push_clause_worker should not hold the lock");
-                    }
-                    return true;
-                }());
-                if (not header.empty()) {
-                    write_lemma(m_clauses, header);
-                    m_clauses->clear();
+            auto m_clauses = getChannel().swap_learned_clauses();
+            getChannel().clear_learned_clauses();
+            auto header = getChannel().get_current_header();
+            lk.unlock();
+            assert([&]() {
+                if (lk.owns_lock()) {
+                    throw PTPLib::common::Exception(__FILE__, __LINE__, "push_clause_worker should not hold the lock");
                 }
+                return true;
+            }());
+            if (not header.empty()) {
+                write_lemma(m_clauses, header);
+                m_clauses->clear();
             }
-            else stream.println(color_enabled ? PTPLib::common::Color::FG_Blue : PTPLib::common::Color::FG_DEFAULT,
-                                "[t PUSH ] -> Channel empty!");
-        }
-        else if (getChannel().shouldReset())
-            break;
-
-        else {
-            stream.println(color_enabled ? PTPLib::common::Color::FG_Blue : PTPLib::common::Color::FG_DEFAULT,
-                           "[t PUSH ] -> ", "spurious wake up!");
-            assert(false);
         }
-    }
+        else PTPLIB_LOG(stream, Info, PUSH, color_enabled ? PTPLib::common::Color::FG_Blue : PTPLib::common::Color::FG_DEFAULT,
+                        "[t PUSH ] -> Channel empty!");
+    }, "CLAUSEPUSH", reset_token());
 }
 
 void Listener::pull_clause_worker(double seed, double min, double max)
 {
-    pull_thread_id = std::this_thread::get_id();
     int pull_duration = (waiting_duration ? waiting_duration*(200) : min + ( std::fmod(seed, ( max - min + 1 ))));
-    stream.println(color_enabled ? PTPLib::common::Color::FG_Magenta : PTPLib::common::Color::FG_DEFAULT,
-                   "[t PULL -> timout : ", pull_duration," ms");
-    PTPLib::net::time_duration wakeupAt = std::chrono::milliseconds (pull_duration);
-    while (true) {
-
-        PTPLib::common::PrintStopWatch psw("[t PULL ] -> measured wait and read duration: ", stream,
-                                   color_enabled ? PTPLib::common::Color::FG_Magenta : PTPLib::common::Color::FG_DEFAULT);
-        std::unique_lock<std::mutex> lk(getChannel().getMutex());
-        bool reset = getChannel().wait_for_reset(lk, wakeupAt);
+    PTPLIB_LOG(stream, Info, PULL, color_enabled ? PTPLib::common::Color::FG_Magenta : PTPLib::common::Color::FG_DEFAULT,
+               "[t PULL -> timout : ", pull_duration," ms");
+    const auto pull_scope = latencies.scope("[t PULL ] -> read");
+    th_pool.schedule_every(std::chrono::milliseconds(pull_duration), [this, pull_scope]
+    {
+        PTPLib::common::ScopedLatencyRecorder recorder(latencies, pull_scope);
+        std::unique_lock<PTPLib::net::channel_mutex> lk(getChannel().getMutex());
         assert([&]() {
-            if (pull_thread_id != std::this_thread::get_id())
-                throw PTPLib::common::Exception(__FILE__, __LINE__, "pull_clause_worker has inconsistent thread id");
-
             if (not lk.owns_lock()) {
                 throw PTPLib::common::Exception(__FILE__, __LINE__, "pull_clause_worker can't take the lock");
             }
             return true;
         }());
-        if (not reset)
+        if (getChannel().shouldReset())
+            return;
+
+        auto header = channel.get_current_header();
+        lk.unlock();
+        assert([&]() {
+            if (lk.owns_lock()) {
+                throw PTPLib::common::Exception(__FILE__, __LINE__, "pull_clause_worker should not hold the lock");
+            }
+
+            return true;
+        }());
+        if (header.empty())
+            return;
+
+        std::vector<PTPLib::net::Lemma> lemmas;
+        if (not this->read_lemma(lemmas, header))
+            return;
+
+        PTPLIB_LOG(stream, Info, PULL, color_enabled ? PTPLib::common::Color::FG_Magenta : PTPLib::common::Color::FG_DEFAULT,
+                   "[t PULL ] -> pulled learned clauses copied to channel buffer, Size: ",
+                   lemmas.size());
         {
-            auto header = channel.get_current_header();
-            lk.unlock();
+            std::unique_lock<PTPLib::net::channel_mutex> _lk(getChannel().getMutex());
             assert([&]() {
-                if (lk.owns_lock()) {
-                    throw PTPLib::common::Exception(__FILE__, __LINE__, "pull_clause_worker should not hold the lock");
+                if (not _lk.owns_lock()) {
+                    throw PTPLib::common::Exception(__FILE__, __LINE__, "pull_clause_worker can't take the lock");
                 }
-
                 return true;
             }());
-            if (not header.empty()) {
-                std::vector<PTPLib::net::Lemma> lemmas;
-                if (this->read_lemma(lemmas, header)) {
-                    stream.println(color_enabled ? PTPLib::common::Color::FG_Magenta : PTPLib::common::Color::FG_DEFAULT,
-                                   "[t PULL ] -> pulled learned clauses copied to channel buffer, Size: ",
-                                   lemmas.size());
-                    {
-                        std::unique_lock<std::mutex> _lk(getChannel().getMutex());
-                        assert([&]() {
-                            if (not _lk.owns_lock()) {
-                                throw PTPLib::common::Exception(__FILE__, __LINE__, "pull_clause_worker can't take the lock");
-                            }
-                            return true;
-                        }());
-
-                        if (getChannel().shouldReset())
-                            break;
-                        channel.insert_pulled_clause(std::move(lemmas));
-                        header.erase(PTPLib::common::Param.COMMAND);
-                        header[PTPLib::common::Param.COMMAND] = PTPLib::common::Command.CLAUSEINJECTION;
-                        queue_event(PTPLib::net::SMTS_Event(std::move(header), ""));
-                        _lk.unlock();
-                    }
-                    stream.println(color_enabled ? PTPLib::common::Color::FG_Magenta : PTPLib::common::Color::FG_DEFAULT,
-                                   "[t PULL ] -> ", PTPLib::common::Command.CLAUSEINJECTION, " is queued and notified");
-                }
-            }
-        } else if (getChannel().shouldReset())
-            break;
 
-        else {
-                stream.println(color_enabled ? PTPLib::common::Color::FG_Magenta : PTPLib::common::Color::FG_DEFAULT,
-                               "[t PULL ] -> ", "spurious wake up!");
-                assert(false);
-            }
-    }
+            if (getChannel().shouldReset())
+                return;
+            channel.insert_pulled_clause(std::move(lemmas));
+            header.erase(PTPLib::common::Param.COMMAND);
+            header[PTPLib::common::Param.COMMAND] = PTPLib::common::Command.CLAUSEINJECTION;
+            queue_event(PTPLib::net::SMTS_Event(std::move(header), ""));
+            _lk.unlock();
+        }
+        PTPLIB_LOG(stream, Info, PULL, color_enabled ? PTPLib::common::Color::FG_Magenta : PTPLib::common::Color::FG_DEFAULT,
+                   "[t PULL ] -> ", PTPLib::common::Command.CLAUSEINJECTION, " is queued and notified");
+    }, "CLAUSEPULL", reset_token());
 }
 
 bool Listener::read_lemma(std::vector<PTPLib::net::Lemma>  & lemmas, PTPLib::net::Header & header) {
@@ -299,8 +301,8 @@ bool Listener::write_lemma(std::unique_ptr<std::map<std::string, std::vector<PTP
     for (const auto &node_clauses : *m_clauses)
     {
         std::this_thread::sleep_for(std::chrono::milliseconds (int(waiting_duration ? (waiting_duration*100) :  m_clauses->size())));
-        stream.println(color_enabled ? PTPLib::common::Color::FG_Blue : PTPLib::common::Color::FG_DEFAULT,
-                       "[t PUSH ] -> push learned clauses to Cloud Clause Size: ", node_clauses.second.size());
+        PTPLIB_LOG(stream, Info, PUSH, color_enabled ? PTPLib::common::Color::FG_Blue : PTPLib::common::Color::FG_DEFAULT,
+                   "[t PUSH ] -> push learned clauses to Cloud Clause Size: ", node_clauses.second.size());
     }
     header.at(PTPLib::common::Param.NODE);
     return true;
@@ -310,22 +312,12 @@ void Listener::periodic_clauseLearning_worker()
 {
     int random_n = waiting_duration ? waiting_duration * (100) : SMTSolver::generate_rand(1000, 2000);
     if (getChannel().isClauseShareMode()) {
-        while (true)
+        th_pool.schedule_every(std::chrono::milliseconds(static_cast<int>(random_n*2)), [this]
         {
-            std::unique_lock<std::mutex> lk(channel.getMutex());
-            if (getChannel().wait_for_reset(lk, std::chrono::milliseconds(static_cast<int>(random_n*2))))
-                break;
-            assert([&]() {
-                if (not lk.owns_lock()) {
-                    throw PTPLib::common::Exception(__FILE__, __LINE__, "periodic_clauseLearning_worker can't take the lock");
-                }
-                return true;
-            }());
+            std::scoped_lock<PTPLib::net::channel_mutex> lk(channel.getMutex());
             getChannel().setShouldLearnClauses();
-            lk.unlock();
-        }
-        stream.println(color_enabled ? PTPLib::common::Color::FG_BrightBlue : PTPLib::common::Color::FG_DEFAULT,
-                       "[t CLAUSELEARN ] -> clause learn timout: ", random_n);
+        }, "CLAUSELEARN", reset_token());
+        PTPLIB_LOG(stream, Debug, CLAUSE_LEARN, color_enabled ? PTPLib::common::Color::FG_BrightBlue : PTPLib::common::Color::FG_DEFAULT,
+                   "[t CLAUSELEARN ] -> clause learn timout: ", random_n);
     }
-
-}
\ No newline at end of file
+}
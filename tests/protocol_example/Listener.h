@@ -4,21 +4,36 @@
 #include <PTPLib/net/Channel.hpp>
 #include <PTPLib/net/Header.hpp>
 #include <PTPLib/common/PartitionConstant.hpp>
+#include <PTPLib/common/LatencyRegistry.hpp>
+#include <PTPLib/common/Memory.hpp>
+#include <PTPLib/common/MemoryPressure.hpp>
 #include <PTPLib/threads/ThreadPool.hpp>
 
+#include <memory>
+#include <optional>
+
 class Listener {
+    // Lives from memory_checker until the reset, while its watcher thread sheds pulled clauses under pressure.
+    struct memory_monitor {
+        PTPLib::common::MemoryBudget budget;
+        std::optional<PTPLib::common::MemoryPressureWatcher> watcher;
+
+        memory_monitor(std::size_t soft_limit, std::size_t hard_limit) : budget(soft_limit, hard_limit) {}
+    };
+
     PTPLib::net::Channel<PTPLib::net::SMTS_Event, PTPLib::net::Lemma> channel;
     PTPLib::threads::ThreadPool th_pool;
     Communicator communicator;
     PTPLib::common::synced_stream & stream;
     PTPLib::common::StoppableWatch timer;
+    PTPLib::common::LatencyRegistry latencies;
     bool color_enabled;
     int nCommands;
     int instanceNum;
     double waiting_duration;
-    std::atomic<std::thread::id> memory_thread_id;
-    std::atomic<std::thread::id> push_thread_id;
-    std::atomic<std::thread::id> pull_thread_id;
+    std::shared_ptr<memory_monitor> memory;
+
+    PTPLib::threads::stop_token reset_token();
 public:
 
     Listener(PTPLib::common::synced_stream & ss, const bool & ce, double wd)
@@ -60,5 +75,7 @@ public:
 
     PTPLib::threads::ThreadPool & getPool() { return th_pool; }
 
+    PTPLib::common::LatencyRegistry & getLatencies() { return latencies; }
+
     void periodic_clauseLearning_worker();
 };
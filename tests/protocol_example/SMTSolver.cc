@@ -27,21 +27,15 @@ SMTSolver::Result SMTSolver::do_solve() {
     if (channel.shouldLearnClauses()) {
         channel.clearShouldLearnClauses();
         if (learnSomeClauses(toPublishClauses)) {
-            std::unique_lock<std::mutex> lk(channel.getMutex());
             assert([&]() {
                 if (thread_id != std::this_thread::get_id())
                     throw PTPLib::common::Exception(__FILE__, __LINE__, "search has inconsistent thread id");
-
-                if (not lk.owns_lock()) {
-                    throw PTPLib::common::Exception(__FILE__, __LINE__, "search can't take the lock");
-                }
                 return true;
             }());
-            stream.println(color_enabled ? PTPLib::common::Color::FG_Green : PTPLib::common::Color::FG_DEFAULT,
-                           "[t SEARCH ] -> add learned clauses to channel buffer, Size : ",
-                           toPublishClauses.size());
-            channel.insert_learned_clause(std::move(toPublishClauses));
-            lk.unlock();
+            PTPLIB_LOG(stream, Info, SEARCH, color_enabled ? PTPLib::common::Color::FG_Green : PTPLib::common::Color::FG_DEFAULT,
+                       "[t SEARCH ] -> add learned clauses to channel buffer, Size : ",
+                       toPublishClauses.size());
+            channel.publish_learned_clauses(toPublishClauses, instance_epoch);
             return Result::UNKNOWN;
         } else
             return std::rand() < RAND_MAX / 2 ? Result::SAT : Result::UNSAT;
@@ -49,11 +43,13 @@ SMTSolver::Result SMTSolver::do_solve() {
     return Result::UNKNOWN;
 }
 
-SMTSolver::Result SMTSolver::search(char * smt_lib) {
+SMTSolver::Result SMTSolver::search(PTPLib::threads::stop_token token, char * smt_lib) {
     thread_id = std::this_thread::get_id();
+    instance_epoch = channel.get_epoch();
+    PTPLib::threads::stop_callback interrupt(token, [this] { channel.setShouldStop(); });
     assert (smt_lib);
-    stream.println(color_enabled ? PTPLib::common::Color::FG_Green : PTPLib::common::Color::FG_DEFAULT,
-                   "[t SEARCH ] -> instance: ", smt_lib);
+    PTPLIB_LOG(stream, Info, SEARCH, color_enabled ? PTPLib::common::Color::FG_Green : PTPLib::common::Color::FG_DEFAULT,
+               "[t SEARCH ] -> instance: ", smt_lib);
     Result solver_result = Result::UNKNOWN;
     while (not channel.shouldStop())
     {
@@ -61,21 +57,21 @@ SMTSolver::Result SMTSolver::search(char * smt_lib) {
         if (solver_result != Result::UNKNOWN) {
             channel.setShallStop();
             channel.notify_all();
-            stream.println(color_enabled ? PTPLib::common::Color::FG_Green : PTPLib::common::Color::FG_DEFAULT,
-                           "[t SEARCH ] -> set shall stop");
+            PTPLIB_LOG(stream, Info, SEARCH, color_enabled ? PTPLib::common::Color::FG_Green : PTPLib::common::Color::FG_DEFAULT,
+                       "[t SEARCH ] -> set shall stop");
             break;
         }
     }
-    stream.println(color_enabled ? PTPLib::common::Color::FG_Green : PTPLib::common::Color::FG_DEFAULT,
-                   "[t SEARCH ] -> solver exited with ", SMTSolver::resultToString(solver_result));
+    PTPLIB_LOG(stream, Info, SEARCH, color_enabled ? PTPLib::common::Color::FG_Green : PTPLib::common::Color::FG_DEFAULT,
+               "[t SEARCH ] -> solver exited with ", SMTSolver::resultToString(solver_result));
     setResult(solver_result);
     return solver_result;
 }
 
 void SMTSolver::inject_clauses(PTPLib::net::map_solverBranch_lemmas & pulled_clauses)
 {
-    stream.println(color_enabled ? PTPLib::common::Color::FG_Cyan : PTPLib::common::Color::FG_DEFAULT,
-                   "[t COMMUNICATOR ] -> inject pulled clause ");
+    PTPLIB_LOG(stream, Info, COMMUNICATOR, color_enabled ? PTPLib::common::Color::FG_Cyan : PTPLib::common::Color::FG_DEFAULT,
+               "[t COMMUNICATOR ] -> inject pulled clause ");
     for (auto &clauses : pulled_clauses) {
         std::this_thread::sleep_for(std::chrono::milliseconds (int(waiting_duration ? waiting_duration * (100) : clauses.second.size())));
     }
@@ -83,8 +79,8 @@ void SMTSolver::inject_clauses(PTPLib::net::map_solverBranch_lemmas & pulled_cla
 void SMTSolver::initialise_logic()
 {
     timer.start();
-    stream.println(color_enabled ? PTPLib::common::Color::FG_Cyan : PTPLib::common::Color::FG_DEFAULT,
-                   "[t COMMUNICATOR ] -> initialising the logic, time: ", timer.elapsed_time_milliseconds());
+    PTPLIB_LOG(stream, Info, COMMUNICATOR, color_enabled ? PTPLib::common::Color::FG_Cyan : PTPLib::common::Color::FG_DEFAULT,
+               "[t COMMUNICATOR ] -> initialising the logic, time: ", timer.elapsed_time_milliseconds());
     timer.reset();
 }
 
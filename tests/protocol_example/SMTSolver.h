@@ -2,6 +2,7 @@
 #include <PTPLib/net/Channel.hpp>
 #include <PTPLib/common/Printer.hpp>
 #include <PTPLib/net/Header.hpp>
+#include <PTPLib/threads/StopToken.hpp>
 
 class SMTSolver {
 public:
@@ -17,6 +18,7 @@ private:
     bool color_enabled;
     double waiting_duration;
     std::atomic<std::thread::id> thread_id;
+    std::uint64_t instance_epoch;
 
 public:
     SMTSolver(PTPLib::net::Channel<PTPLib::net::SMTS_Event, PTPLib::net::Lemma> & ch, PTPLib::common::synced_stream & st, PTPLib::common::StoppableWatch & tm, const bool & ce, double wd)
@@ -26,7 +28,8 @@ public:
             stream  (st),
             timer   (tm),
             color_enabled(ce),
-            waiting_duration(wd)
+            waiting_duration(wd),
+            instance_epoch(0)
     {}
 
     void setResult(Result res)     { result = res; }
@@ -37,7 +40,7 @@ public:
 
     static int generate_rand(int min, int max);
 
-    SMTSolver::Result search(char * smt_lib);
+    SMTSolver::Result search(PTPLib::threads::stop_token token, char * smt_lib);
 
     void inject_clauses(PTPLib::net::map_solverBranch_lemmas & pulled_clauses);
 
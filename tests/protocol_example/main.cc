@@ -17,14 +17,15 @@ int main(int argc, char** argv) {
     }
 
     PTPLib::common::synced_stream stream(std::clog);
+    stream.set_async();
     PTPLib::common::StoppableWatch solving_watch;
     solving_watch.start();
     std::srand((argc < 4) ? static_cast<std::uint_fast8_t>(solving_watch.elapsed_time_microseconds()) : atoi(argv[4]));
     solving_watch.stop();
 
     int number_instances = atoi(argv[1]) ;
-    stream.println(color_enabled ? PTPLib::common::Color::FG_Red : PTPLib::common::Color::FG_DEFAULT,
-                   "<<---------------------->> Total Number of Instances: ", number_instances," <<------------------------>> ");
+    PTPLIB_LOG(stream, Info, GENERAL, color_enabled ? PTPLib::common::Color::FG_Red : PTPLib::common::Color::FG_DEFAULT,
+               "<<---------------------->> Total Number of Instances: ", number_instances," <<------------------------>> ");
 
     double waiting_duration = (argc < 4) ? 0 : std::stod(argv[3]);
     Listener listener(stream, color_enabled, waiting_duration);
@@ -47,9 +48,9 @@ int main(int argc, char** argv) {
 
         listener.set_eventGen_stat(++instanceNum, nCommands);
 
-        stream.println( color_enabled ? PTPLib::common::Color::FG_Red : PTPLib::common::Color::FG_DEFAULT,
-                        "<********************** Instance: ", instanceNum,
-                        " ( Number of Commands: ", nCommands, ") **********************>");
+        PTPLIB_LOG(stream, Info, GENERAL, color_enabled ? PTPLib::common::Color::FG_Red : PTPLib::common::Color::FG_DEFAULT,
+                   "<********************** Instance: ", instanceNum,
+                   " ( Number of Commands: ", nCommands, ") **********************>");
         int command_counter = 1;
         bool reset = false;
 
@@ -58,10 +59,10 @@ int main(int argc, char** argv) {
             auto event = listener.generate_event(command_counter, solving_watch.elapsed_time_second());
             assert(not event.header[PTPLib::common::Param.COMMAND].empty());
 
-            stream.println(color_enabled ? PTPLib::common::Color::FG_Red : PTPLib::common::Color::FG_DEFAULT,
-                           "[t LISTENER ] -> ", event.header.at(PTPLib::common::Param.COMMAND), " is received and notified" );
+            PTPLIB_LOG(stream, Info, LISTENER, color_enabled ? PTPLib::common::Color::FG_Red : PTPLib::common::Color::FG_DEFAULT,
+                       "[t LISTENER ] -> ", event.header.at(PTPLib::common::Param.COMMAND), " is received and notified" );
             {
-                std::unique_lock<std::mutex> _lk(listener.getChannel().getMutex());
+                std::unique_lock<PTPLib::net::channel_mutex> _lk(listener.getChannel().getMutex());
                 assert([&]() {
                     if (not _lk.owns_lock()) {
                         throw PTPLib::common::Exception(__FILE__, __LINE__, "listener can't take the lock");
@@ -77,13 +78,17 @@ int main(int argc, char** argv) {
         listener.notify_reset();
         listener.getPool().wait_for_tasks();
         assert(not listener.getPool().get_tasks_total());
+        listener.getLatencies().print(stream, color_enabled ? PTPLib::common::Color::FG_Red : PTPLib::common::Color::FG_DEFAULT);
         {
-            std::scoped_lock<std::mutex> _lk(listener.getChannel().getMutex());
+            std::scoped_lock<PTPLib::net::channel_mutex> _lk(listener.getChannel().getMutex());
             listener.getChannel().resetChannel();
         }
         solving_watch.reset();
         number_instances--;
     }
+#ifdef PTPLIB_PROFILE_LOCKS
+    PTPLib::threads::lock_profiler::instance().write_report(std::cerr);
+#endif
     return 0;
 }
 